@@ -0,0 +1,559 @@
+#include "RoseAssetGenerator.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+#include "Common.h"
+#include "Zms.h"
+#include "Zmo.h"
+#include "Zsc.h"
+#include "Til.h"
+#include "Ifo.h"
+#include "Zon.h"
+
+namespace RoseAssetGenerator {
+
+// World units covered by one tile, and height samples along one tile edge, matching the landscape import
+static const float TileWorldSize = 16000.0f;
+static const int32 TileHeightSamples = 64;
+
+// Smooth height field over the whole zone so neighbouring tiles share their edge samples
+static float HeightAt(float GlobalX, float GlobalY, float Amplitude) {
+	return Amplitude * (FMath::Sin(GlobalX * 0.02f) * FMath::Cos(GlobalY * 0.015f) + 0.5f * FMath::Sin((GlobalX + GlobalY) * 0.005f));
+}
+
+static FQuat RandomYaw(FRandomStream& Random) {
+	return FQuat(FVector::UpVector, Random.FRandRange(0.0f, 2.0f * PI));
+}
+
+TArray<uint32> GetZmsFormatCombinations() {
+	const uint32 Optional[] = {
+		Zms::ZMSF_NORMAL, Zms::ZMSF_COLOR, Zms::ZMSF_BLENDWEIGHT, Zms::ZMSF_BLENDINDEX, Zms::ZMSF_TANGENT,
+		Zms::ZMSF_UV1, Zms::ZMSF_UV2, Zms::ZMSF_UV3, Zms::ZMSF_UV4
+	};
+
+	TArray<uint32> Formats;
+	for (uint32 mask = 0; mask < (1u << ARRAY_COUNT(Optional)); ++mask) {
+		uint32 Format = Zms::ZMSF_POSITION;
+		for (int32 b = 0; b < ARRAY_COUNT(Optional); ++b) {
+			if (mask & (1u << b)) {
+				Format |= Optional[b];
+			}
+		}
+		Formats.Add(Format);
+	}
+	return Formats;
+}
+
+TArray<uint8> MakeZms(uint32 Format, int32 GridSize, int32 BoneCount, FRandomStream& Random) {
+	// Vertices and faces are both counted with a uint16, 182x182 is the largest grid whose (n-1)^2*2 faces still fit
+	const int32 n = FMath::Clamp(GridSize, 2, 182);
+	const bool bSkinned = (Format & Zms::ZMSF_BLENDWEIGHT) && (Format & Zms::ZMSF_BLENDINDEX);
+	const int32 boneCount = bSkinned ? FMath::Max(BoneCount, 1) : 0;
+	const int32 vertexCount = n * n;
+	const int32 faceCount = (n - 1) * (n - 1) * 2;
+
+	WriteHelper wh;
+	wh.write("ZMS0008", 8);
+	wh.write<uint32>(Format);
+	wh.write(FVector(-1.0f, -1.0f, 0.0f));
+	wh.write(FVector(1.0f, 1.0f, 0.1f));
+
+	wh.write<uint16>(boneCount);
+	for (int32 i = 0; i < boneCount; ++i) {
+		wh.write<uint16>(i);
+	}
+
+	wh.write<uint16>(vertexCount);
+	for (int32 y = 0; y < n; ++y) {
+		for (int32 x = 0; x < n; ++x) {
+			wh.write(FVector((float)x / (n - 1) * 2.0f - 1.0f, (float)y / (n - 1) * 2.0f - 1.0f, Random.FRandRange(0.0f, 0.1f)));
+		}
+	}
+	if (Format & Zms::ZMSF_NORMAL) {
+		for (int32 i = 0; i < vertexCount; ++i) {
+			wh.write(FVector(0.0f, 0.0f, 1.0f));
+		}
+	}
+	if (Format & Zms::ZMSF_COLOR) {
+		for (int32 i = 0; i < vertexCount; ++i) {
+			wh.write<float>(1.0f);
+			wh.write<float>(Random.FRand());
+			wh.write<float>(Random.FRand());
+			wh.write<float>(Random.FRand());
+		}
+	}
+	if (bSkinned) {
+		for (int32 i = 0; i < vertexCount; ++i) {
+			Zms::BoneWeights weights;
+			FMemory::Memzero(weights);
+			weights.weight[0] = 0.75f;
+			weights.weight[1] = 0.25f;
+			weights.boneIdx[0] = i % boneCount;
+			weights.boneIdx[1] = (i + 1) % boneCount;
+			wh.write(weights);
+		}
+	}
+	if (Format & Zms::ZMSF_TANGENT) {
+		for (int32 i = 0; i < vertexCount; ++i) {
+			wh.write(FVector(1.0f, 0.0f, 0.0f));
+		}
+	}
+	const uint32 UvFlags[4] = { Zms::ZMSF_UV1, Zms::ZMSF_UV2, Zms::ZMSF_UV3, Zms::ZMSF_UV4 };
+	for (int32 k = 0; k < 4; ++k) {
+		if (Format & UvFlags[k]) {
+			for (int32 y = 0; y < n; ++y) {
+				for (int32 x = 0; x < n; ++x) {
+					wh.write(FVector2D((float)x / (n - 1), (float)y / (n - 1)));
+				}
+			}
+		}
+	}
+
+	wh.write<uint16>(faceCount);
+	for (int32 y = 0; y < n - 1; ++y) {
+		for (int32 x = 0; x < n - 1; ++x) {
+			uint16 v0 = y * n + x;
+			uint16 v1 = v0 + 1;
+			uint16 v2 = v0 + n;
+			uint16 v3 = v2 + 1;
+			wh.write<uint16>(v0);
+			wh.write<uint16>(v2);
+			wh.write<uint16>(v1);
+			wh.write<uint16>(v1);
+			wh.write<uint16>(v2);
+			wh.write<uint16>(v3);
+		}
+	}
+	return wh.data;
+}
+
+TArray<uint8> MakeZmd(int32 BoneCount, int32 DummyCount) {
+	WriteHelper wh;
+	wh.write("ZMD0003", 7);
+
+	wh.write<uint32>(BoneCount);
+	for (int32 i = 0; i < BoneCount; ++i) {
+		// A chain with a few branches back to the root, bone 0 is its own parent like in the client data
+		wh.write<uint32>(i == 0 ? 0 : ((i % 8 == 0) ? 0 : i - 1));
+		wh.writeStr(FString::Printf(TEXT("b%02d"), i));
+		wh.write(FVector(0.0f, 0.0f, i == 0 ? 0.0f : 0.1f));
+		wh.writeBadQuat(FQuat::Identity);
+	}
+
+	wh.write<uint32>(DummyCount);
+	for (int32 i = 0; i < DummyCount; ++i) {
+		wh.write<uint32>(FMath::Max(BoneCount - 1, 0));
+		wh.writeStr(FString::Printf(TEXT("p%02d"), i));
+		wh.write(FVector(0.05f * i, 0.0f, 0.0f));
+		wh.writeBadQuat(FQuat::Identity);
+	}
+	return wh.data;
+}
+
+TArray<uint8> MakeZmo(int32 BoneCount, int32 FrameCount, uint32 FramesPerSecond, FRandomStream& Random) {
+	WriteHelper wh;
+	wh.writeStr(TEXT("ZMO0002"));
+	wh.write<uint32>(FramesPerSecond);
+	wh.write<uint32>(FrameCount);
+
+	// One position and one rotation channel per bone
+	wh.write<uint32>(BoneCount * 2);
+	for (int32 i = 0; i < BoneCount; ++i) {
+		wh.write<uint32>(Zmo::ChannelType::Position);
+		wh.write<uint32>(i);
+		wh.write<uint32>(Zmo::ChannelType::Rotation);
+		wh.write<uint32>(i);
+	}
+
+	TArray<float> phases;
+	for (int32 i = 0; i < BoneCount; ++i) {
+		phases.Add(Random.FRandRange(0.0f, 2.0f * PI));
+	}
+
+	for (int32 f = 0; f < FrameCount; ++f) {
+		const float t = (float)f / FMath::Max(FrameCount, 1) * 2.0f * PI;
+		for (int32 i = 0; i < BoneCount; ++i) {
+			wh.write(FVector(0.0f, 0.0f, i == 0 ? 0.0f : 0.1f));
+			wh.writeBadQuat(FQuat(FVector::ForwardVector, 0.2f * FMath::Sin(t + phases[i])));
+		}
+	}
+	return wh.data;
+}
+
+static void WriteZscProperty(WriteHelper& wh, uint8 Type, const void* Data, uint8 Size) {
+	wh.write<uint8>(Type);
+	wh.write<uint8>(Size);
+	wh.write(Data, Size);
+}
+
+TArray<uint8> MakeZsc(const TArray<FString>& Meshes, const TArray<FString>& Textures, int32 ModelCount, int32 PartsPerModel, bool bSkinned, FRandomStream& Random) {
+	WriteHelper wh;
+	wh.write<uint16>(Meshes.Num());
+	for (int32 i = 0; i < Meshes.Num(); ++i) {
+		wh.writeStr(Meshes[i]);
+	}
+
+	wh.write<uint16>(Textures.Num());
+	for (int32 i = 0; i < Textures.Num(); ++i) {
+		const bool bAlphaTest = (i % 4) == 1;
+		wh.writeStr(Textures[i]);
+		wh.write<uint16>(bSkinned ? 1 : 0); // useSkinShader
+		wh.write<uint16>((i % 4) == 2 ? 1 : 0); // alphaEnabled
+		wh.write<uint16>((i % 3) == 0 ? 1 : 0); // twoSided
+		wh.write<uint16>(bAlphaTest ? 1 : 0); // alphaTestEnabled
+		wh.write<uint16>(bAlphaTest ? 100 : 128); // alphaReference
+		wh.write<uint16>(1); // depthTestEnabled
+		wh.write<uint16>(1); // depthWriteEnabled
+		wh.write<uint16>(0); // blendType
+		wh.write<uint16>(0); // useSpecularShader
+		wh.write<float>(1.0f);
+		wh.write<uint16>(0); // glowType
+		wh.writeColor3(FLinearColor::White);
+	}
+
+	wh.write<uint16>(0); // effect files
+
+	wh.write<uint16>(ModelCount);
+	for (int32 i = 0; i < ModelCount; ++i) {
+		wh.write<int32>(0);
+		wh.write<int32>(0);
+		wh.write<int32>(0);
+
+		wh.write<uint16>(PartsPerModel);
+		for (int32 j = 0; j < PartsPerModel; ++j) {
+			wh.write<uint16>(Random.RandHelper(Meshes.Num()));
+			wh.write<uint16>(Random.RandHelper(Textures.Num()));
+
+			if (!bSkinned) {
+				if (j > 0) {
+					// Parents are stored 1-based, every extra part hangs off the first one
+					uint16 parent = 1;
+					WriteZscProperty(wh, Zsc::PropertyType::Parent, &parent, sizeof(parent));
+				}
+
+				FVector position(Random.FRandRange(-2.0f, 2.0f), Random.FRandRange(-2.0f, 2.0f), Random.FRandRange(0.0f, 2.0f));
+				WriteZscProperty(wh, Zsc::PropertyType::Position, &position, sizeof(position));
+
+				FQuat yaw = RandomYaw(Random);
+				float rotation[4] = { yaw.W, yaw.X, yaw.Y, yaw.Z };
+				WriteZscProperty(wh, Zsc::PropertyType::Rotation, rotation, sizeof(rotation));
+
+				FVector scale(Random.FRandRange(0.5f, 2.0f));
+				WriteZscProperty(wh, Zsc::PropertyType::Scale, &scale, sizeof(scale));
+
+				uint16 collision = (uint16)Random.RandRange(Zsc::CollisionType::None, Zsc::CollisionType::Polygon);
+				if (Random.RandHelper(4) == 0) {
+					collision |= Zsc::CollisionType::NotPickable;
+				}
+				WriteZscProperty(wh, Zsc::PropertyType::Collision, &collision, sizeof(collision));
+			}
+
+			wh.write<uint8>(0);
+		}
+
+		wh.write<uint16>(0); // effects
+		wh.write(FVector(-2.0f, -2.0f, 0.0f));
+		wh.write(FVector(2.0f, 2.0f, 4.0f));
+	}
+	return wh.data;
+}
+
+TArray<uint8> MakeChr(const FString& ZmdPath, const TArray<FString>& Animations, int32 CharacterCount, int32 ModelCount, FRandomStream& Random) {
+	WriteHelper wh;
+	wh.write<uint16>(1);
+	wh.writeStr(ZmdPath);
+
+	wh.write<uint16>(Animations.Num());
+	for (int32 i = 0; i < Animations.Num(); ++i) {
+		wh.writeStr(Animations[i]);
+	}
+
+	wh.write<uint16>(0); // effect files
+
+	wh.write<uint16>(CharacterCount);
+	for (int32 i = 0; i < CharacterCount; ++i) {
+		wh.write<uint8>(1);
+		wh.write<uint16>(0);
+		wh.writeStr(FString::Printf(TEXT("SYN_NPC_%d"), i));
+
+		const int32 modelCount = FMath::Min(1 + Random.RandHelper(2), ModelCount);
+		wh.write<uint16>(modelCount);
+		for (int32 j = 0; j < modelCount; ++j) {
+			wh.write<uint16>(Random.RandHelper(ModelCount));
+		}
+
+		wh.write<uint16>(Animations.Num());
+		for (int32 j = 0; j < Animations.Num(); ++j) {
+			wh.write<uint16>(j);
+			wh.write<uint16>(j);
+		}
+
+		wh.write<uint16>(0); // effects
+	}
+	return wh.data;
+}
+
+TArray<uint8> MakeHim(int32 TileX, int32 TileY, float Amplitude) {
+	WriteHelper wh;
+	wh.write<uint32>(TileHeightSamples + 1);
+	wh.write<uint32>(TileHeightSamples + 1);
+	wh.write<uint32>(4);
+	wh.write<float>(TileWorldSize / TileHeightSamples);
+
+	for (int32 y = 0; y <= TileHeightSamples; ++y) {
+		for (int32 x = 0; x <= TileHeightSamples; ++x) {
+			wh.write<float>(HeightAt(TileX * TileHeightSamples + x, TileY * TileHeightSamples + y, Amplitude));
+		}
+	}
+	return wh.data;
+}
+
+TArray<uint8> MakeTil(FRandomStream& Random) {
+	WriteHelper wh;
+	wh.write<uint32>(16);
+	wh.write<uint32>(16);
+	for (int32 i = 0; i < 16 * 16; ++i) {
+		Til::FTile tile;
+		tile.Brush = Random.RandHelper(8);
+		tile.TileIndex = Random.RandHelper(16);
+		tile.TileSet = Random.RandHelper(4);
+		tile.Tile = Random.RandHelper(256);
+		wh.write(tile);
+	}
+	return wh.data;
+}
+
+static void WriteIfoObject(WriteHelper& wh, const FString& Name, uint32 ObjectID, int32 TileX, int32 TileY, const FRoseSynthOptions& Options, FRandomStream& Random) {
+	// Same placement the landscape import uses, so objects land inside their own tile and on the ground
+	const float localX = Random.FRandRange(0.0f, TileWorldSize);
+	const float localY = Random.FRandRange(0.0f, TileWorldSize);
+	const float height = HeightAt(TileX * TileHeightSamples + localX / TileWorldSize * TileHeightSamples,
+		TileY * TileHeightSamples + localY / TileWorldSize * TileHeightSamples, Options.HeightAmplitude);
+	const FVector uePosition((TileX - 32) * TileWorldSize - TileWorldSize / 2 + localX, (TileY - 32) * TileWorldSize - TileWorldSize / 2 + localY, height);
+
+	wh.writeByteStr(Name);
+	wh.write<uint16>(0); // WarpId
+	wh.write<uint16>(0); // EventId
+	wh.write<uint32>(0); // ObjectType
+	wh.write<uint32>(ObjectID);
+	wh.write<uint32>(TileX);
+	wh.write<uint32>(TileY);
+	// The ROSE to Unreal conversions flip axes and are their own inverse
+	wh.write(rtuRotation(RandomYaw(Random)));
+	wh.write(rtuPosition(uePosition));
+	wh.write(FVector(Random.FRandRange(0.8f, 1.2f)));
+}
+
+TArray<uint8> MakeIfo(int32 TileX, int32 TileY, const FRoseSynthOptions& Options, FRandomStream& Random) {
+	const uint32 blockTypes[] = { Ifo::EBlockType::Object, Ifo::EBlockType::Building, Ifo::EBlockType::CollisionObject };
+	const int32 blockCounts[] = { Options.ObjectsPerTile, Options.BuildingsPerTile, Options.CollisionsPerTile };
+	const int32 modelCounts[] = { Options.DecoModels, Options.BuildingModels, 1 };
+
+	WriteHelper wh;
+	wh.write<uint32>(ARRAY_COUNT(blockTypes));
+	TArray<int32> offsetPos;
+	for (int32 b = 0; b < ARRAY_COUNT(blockTypes); ++b) {
+		wh.write<uint32>(blockTypes[b]);
+		offsetPos.Add(wh.tell());
+		wh.write<uint32>(0);
+	}
+
+	for (int32 b = 0; b < ARRAY_COUNT(blockTypes); ++b) {
+		wh.patch<uint32>(offsetPos[b], wh.tell());
+		wh.write<uint32>(blockCounts[b]);
+		for (int32 i = 0; i < blockCounts[b]; ++i) {
+			WriteIfoObject(wh, FString::Printf(TEXT("SYN_%d_%d"), b, i), Random.RandHelper(FMath::Max(modelCounts[b], 1)), TileX, TileY, Options, Random);
+		}
+	}
+	return wh.data;
+}
+
+TArray<uint8> MakeZon(const FRoseSynthOptions& Options, const TArray<FString>& Textures) {
+	const uint32 blockTypes[] = { Zon::EBlockType::BasicInfo, Zon::EBlockType::EventPoints, Zon::EBlockType::Textures, Zon::EBlockType::Tiles, Zon::EBlockType::Economy };
+	const int32 gridSize = 64;
+
+	WriteHelper wh;
+	wh.write<uint32>(ARRAY_COUNT(blockTypes));
+	TArray<int32> offsetPos;
+	for (int32 b = 0; b < ARRAY_COUNT(blockTypes); ++b) {
+		wh.write<uint32>(blockTypes[b]);
+		offsetPos.Add(wh.tell());
+		wh.write<uint32>(0);
+	}
+
+	wh.patch<uint32>(offsetPos[0], wh.tell());
+	wh.write<int32>(0); // ZoneType
+	wh.write<int32>(gridSize);
+	wh.write<int32>(gridSize);
+	wh.write<int32>(16);
+	wh.write<float>(TileWorldSize / 16);
+	wh.write<int32>(Options.StartX);
+	wh.write<int32>(Options.StartY);
+	for (int32 y = 0; y < gridSize; ++y) {
+		for (int32 x = 0; x < gridSize; ++x) {
+			const bool bUsed = x >= Options.StartX && x < Options.StartX + Options.TilesX && y >= Options.StartY && y < Options.StartY + Options.TilesY;
+			wh.write<uint8>(bUsed ? 1 : 0);
+			wh.write<float>(x * TileWorldSize);
+			wh.write<float>(y * TileWorldSize);
+		}
+	}
+
+	wh.patch<uint32>(offsetPos[1], wh.tell());
+	wh.write<int32>(1);
+	const FVector start((Options.StartX + Options.TilesX / 2 - 32) * TileWorldSize, (Options.StartY + Options.TilesY / 2 - 32) * TileWorldSize, 0.0f);
+	wh.write(rtuPosition(start));
+	wh.writeByteStr(TEXT("start"));
+
+	wh.patch<uint32>(offsetPos[2], wh.tell());
+	wh.write<int32>(Textures.Num());
+	for (const FString& Texture : Textures) {
+		wh.writeByteStr(Texture);
+	}
+
+	wh.patch<uint32>(offsetPos[3], wh.tell());
+	wh.write<int32>(Textures.Num());
+	for (int32 i = 0; i < Textures.Num(); ++i) {
+		wh.write<int32>(i); // Layer1
+		wh.write<int32>(i); // Layer2
+		wh.write<int32>(0); // Offset1
+		wh.write<int32>(0); // Offset2
+		wh.write<int32>(0); // IsBlending
+		wh.write<int32>(0); // Rotation
+		wh.write<int32>(0); // TileType
+	}
+
+	wh.patch<uint32>(offsetPos[4], wh.tell());
+	wh.writeByteStr(Options.MapName);
+	wh.write<int32>(0); // IsUnderground
+	wh.writeByteStr(TEXT("")); // BackgroundMusic
+	wh.writeByteStr(TEXT("")); // Sky
+	// CheckRate, PopulationBase, PopulationGrowth and the ten consumption rates
+	for (int32 i = 0; i < 3 + 10; ++i) {
+		wh.write<int32>(0);
+	}
+	return wh.data;
+}
+
+TArray<uint8> MakeStb(const TArray<TArray<FString>>& Rows, int32 ColumnCount) {
+	auto writeShortStr = [](WriteHelper& wh, const FString& str) {
+		FTCHARToUTF8 conv(*str);
+		wh.write<uint16>(conv.Length());
+		wh.write(conv.Get(), conv.Length());
+	};
+
+	WriteHelper wh;
+	wh.write("STB1", 4);
+	const int32 dataOffsetPos = wh.tell();
+	wh.write<uint32>(0);
+	wh.write<uint32>(Rows.Num() + 1); // The header row is counted too
+	wh.write<uint32>(ColumnCount);
+	wh.write<uint32>(20); // Row height
+	for (int32 i = 0; i < ColumnCount + 1; ++i) {
+		wh.write<uint16>(100); // Column widths
+	}
+	for (int32 i = 0; i < ColumnCount; ++i) {
+		writeShortStr(wh, FString::Printf(TEXT("COL_%d"), i));
+	}
+	for (const TArray<FString>& Row : Rows) {
+		writeShortStr(wh, Row.IsValidIndex(0) ? Row[0] : FString());
+	}
+
+	wh.patch<uint32>(dataOffsetPos, wh.tell());
+	for (const TArray<FString>& Row : Rows) {
+		for (int32 i = 1; i < ColumnCount; ++i) {
+			writeShortStr(wh, Row.IsValidIndex(i) ? Row[i] : FString());
+		}
+	}
+	return wh.data;
+}
+
+static bool SaveFile(const TArray<uint8>& Data, const FString& OutDir, const FString& RosePath, int32& FileCount) {
+	if (!FFileHelper::SaveArrayToFile(Data, *(OutDir / RosePath))) {
+		UE_LOG(LogTemp, Error, TEXT("Failed to write synthetic file - %s"), *(OutDir / RosePath));
+		return false;
+	}
+	++FileCount;
+	return true;
+}
+
+int32 GenerateZones(const FString& OutDir, const FRoseSynthOptions& Options) {
+	FRandomStream Random(Options.Seed);
+	int32 FileCount = 0;
+
+	const FString ZoneDir = FString(TEXT("3DDATA")) / Options.ZoneName;
+
+	// Textures are referenced but not written, the importer skips materials whose image is missing
+	TArray<FString> Textures;
+	for (int32 i = 0; i < 8; ++i) {
+		Textures.Add(ZoneDir / FString::Printf(TEXT("TEXTURE/SYN_%02d.DDS"), i));
+	}
+
+	// Meshes are shared by every map's lists, the way a client zone folder shares them
+	TArray<FString> StaticMeshes;
+	TArray<FString> SkinnedMeshes;
+	TArray<uint32> Formats = GetZmsFormatCombinations();
+	for (int32 i = 0; i < Formats.Num(); ++i) {
+		const bool bSkinned = (Formats[i] & Zms::ZMSF_BLENDWEIGHT) && (Formats[i] & Zms::ZMSF_BLENDINDEX);
+		FString MeshPath = bSkinned ? FString::Printf(TEXT("3DDATA/NPC/SYN/SKIN_%04X.ZMS"), Formats[i]) : ZoneDir / FString::Printf(TEXT("MESH/FMT_%04X.ZMS"), Formats[i]);
+		SaveFile(MakeZms(Formats[i], Options.MeshGridSize, Options.BoneCount, Random), OutDir, MeshPath, FileCount);
+		(bSkinned ? SkinnedMeshes : StaticMeshes).Add(MeshPath);
+	}
+
+	// Characters are shared by every zone, the importer reads them from the fixed NPC lists
+	const FString ZmdPath = TEXT("3DDATA/NPC/SYN/SYN_SKEL.ZMD");
+	SaveFile(MakeZmd(Options.BoneCount, 2), OutDir, ZmdPath, FileCount);
+
+	TArray<FString> Animations;
+	for (int32 i = 0; i < Options.AnimCount; ++i) {
+		FString AnimPath = FString::Printf(TEXT("3DDATA/NPC/SYN/ANI_%02d.ZMO"), i);
+		SaveFile(MakeZmo(Options.BoneCount, Options.AnimFrames, 30, Random), OutDir, AnimPath, FileCount);
+		Animations.Add(AnimPath);
+	}
+
+	const int32 NpcModels = FMath::Max(Options.CharacterCount, 1);
+	SaveFile(MakeZsc(SkinnedMeshes, Textures, NpcModels, 2, true, Random), OutDir, TEXT("3DDATA/NPC/PART_NPC.ZSC"), FileCount);
+	SaveFile(MakeChr(ZmdPath, Animations, Options.CharacterCount, NpcModels, Random), OutDir, TEXT("3DDATA/NPC/LIST_NPC.CHR"), FileCount);
+
+	// One row per map for the zone list the importer walks, column 1 is the ZON and columns 11 and 12 the deco and
+	// construction lists
+	TArray<TArray<FString>> ZoneRows;
+	const int32 ZoneCount = FMath::Max(Options.ZoneCount, 1);
+	for (int32 z = 0; z < ZoneCount; ++z) {
+		// A single map keeps the plain name, more are numbered after it
+		FRoseSynthOptions MapOptions = Options;
+		if (ZoneCount > 1) {
+			MapOptions.MapName = FString::Printf(TEXT("%s_%02d"), *Options.MapName, z);
+		}
+		const FString MapDir = FString(TEXT("3DDATA/MAPS")) / Options.ZoneName / MapOptions.MapName;
+
+		// Named like the client's per zone lists, LIST_CNST_JDT.ZSC next to the JUNON maps
+		const FString CnstPath = ZoneDir / FString::Printf(TEXT("LIST_CNST_%s.ZSC"), *MapOptions.MapName);
+		const FString DecoPath = ZoneDir / FString::Printf(TEXT("LIST_DECO_%s.ZSC"), *MapOptions.MapName);
+		SaveFile(MakeZsc(StaticMeshes, Textures, Options.BuildingModels, Options.PartsPerModel, false, Random), OutDir, CnstPath, FileCount);
+		SaveFile(MakeZsc(StaticMeshes, Textures, Options.DecoModels, Options.PartsPerModel, false, Random), OutDir, DecoPath, FileCount);
+
+		for (int32 iy = Options.StartY; iy < Options.StartY + Options.TilesY; ++iy) {
+			for (int32 ix = Options.StartX; ix < Options.StartX + Options.TilesX; ++ix) {
+				const FString TileName = MapDir / FString::Printf(TEXT("%d_%d"), ix, iy);
+				SaveFile(MakeHim(ix, iy, Options.HeightAmplitude), OutDir, TileName + TEXT(".HIM"), FileCount);
+				SaveFile(MakeTil(Random), OutDir, TileName + TEXT(".TIL"), FileCount);
+				SaveFile(MakeIfo(ix, iy, MapOptions, Random), OutDir, TileName + TEXT(".IFO"), FileCount);
+			}
+		}
+
+		// Named after the map and kept next to its tiles, which is where the importer looks for it
+		const FString ZonPath = MapDir / MapOptions.MapName + TEXT(".ZON");
+		SaveFile(MakeZon(MapOptions, Textures), OutDir, ZonPath, FileCount);
+
+		TArray<FString>& ZoneRow = ZoneRows.AddDefaulted_GetRef();
+		ZoneRow.SetNum(13);
+		ZoneRow[0] = MapOptions.MapName;
+		ZoneRow[1] = ZonPath;
+		ZoneRow[11] = DecoPath;
+		ZoneRow[12] = CnstPath;
+	}
+	SaveFile(MakeStb(ZoneRows, 13), OutDir, TEXT("3DDATA/STB/LIST_ZONE.STB"), FileCount);
+
+	return FileCount;
+}
+}
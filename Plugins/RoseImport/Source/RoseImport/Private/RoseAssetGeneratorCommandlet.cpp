@@ -0,0 +1,49 @@
+#include "RoseAssetGeneratorCommandlet.h"
+#include "RoseAssetGenerator.h"
+#include "Misc/Paths.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogRoseAssetGenerator, Log, All);
+
+URoseAssetGeneratorCommandlet::URoseAssetGeneratorCommandlet()
+{
+	IsClient = false;
+	IsEditor = true;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 URoseAssetGeneratorCommandlet::Main(const FString& Params)
+{
+	FString OutDir = FPaths::ProjectSavedDir() / TEXT("RoseImport/Synthetic");
+	FParse::Value(*Params, TEXT("out="), OutDir);
+
+	FRoseSynthOptions Options;
+	FParse::Value(*Params, TEXT("zone="), Options.ZoneName);
+	FParse::Value(*Params, TEXT("map="), Options.MapName);
+	FParse::Value(*Params, TEXT("zones="), Options.ZoneCount);
+	FParse::Value(*Params, TEXT("startx="), Options.StartX);
+	FParse::Value(*Params, TEXT("starty="), Options.StartY);
+	FParse::Value(*Params, TEXT("tilesx="), Options.TilesX);
+	FParse::Value(*Params, TEXT("tilesy="), Options.TilesY);
+	FParse::Value(*Params, TEXT("grid="), Options.MeshGridSize);
+	FParse::Value(*Params, TEXT("buildingmodels="), Options.BuildingModels);
+	FParse::Value(*Params, TEXT("models="), Options.DecoModels);
+	FParse::Value(*Params, TEXT("parts="), Options.PartsPerModel);
+	FParse::Value(*Params, TEXT("buildings="), Options.BuildingsPerTile);
+	FParse::Value(*Params, TEXT("objects="), Options.ObjectsPerTile);
+	FParse::Value(*Params, TEXT("collisions="), Options.CollisionsPerTile);
+	FParse::Value(*Params, TEXT("chars="), Options.CharacterCount);
+	FParse::Value(*Params, TEXT("bones="), Options.BoneCount);
+	FParse::Value(*Params, TEXT("anims="), Options.AnimCount);
+	FParse::Value(*Params, TEXT("frames="), Options.AnimFrames);
+	FParse::Value(*Params, TEXT("height="), Options.HeightAmplitude);
+	FParse::Value(*Params, TEXT("seed="), Options.Seed);
+
+	const double StartTime = FPlatformTime::Seconds();
+	const int32 FileCount = RoseAssetGenerator::GenerateZones(OutDir, Options);
+
+	UE_LOG(LogRoseAssetGenerator, Display, TEXT("Wrote %d files for %d zones of %dx%d tiles to %s in %.2fs"),
+		FileCount, FMath::Max(Options.ZoneCount, 1), Options.TilesX, Options.TilesY, *OutDir, FPlatformTime::Seconds() - StartTime);
+
+	return FileCount > 0 ? 0 : 1;
+}
@@ -11,13 +11,20 @@
 #include "AssetToolsModule.h"
 #include "PackageTools.h"
 #include "Misc/FileHelper.h"
+#include "HAL/FileManager.h"
 #include "Factories/TextureFactory.h"
 #include "Factories/Factory.h"
 #include "Factories/MaterialFactoryNew.h"
+#include "Factories/WorldFactory.h"
 #include "LevelEditor.h"
 #include "AssetRegistryModule.h"
 #include "UObject/UObjectGlobals.h"
 #include "Materials/MaterialExpressionTextureSampleParameter2D.h"
+#include "Materials/MaterialExpressionTextureCoordinate.h"
+#include "Materials/MaterialExpressionVectorParameter.h"
+#include "Materials/MaterialExpressionComponentMask.h"
+#include "Materials/MaterialExpressionMultiply.h"
+#include "Materials/MaterialExpressionAdd.h"
 #include "UObject/UObjectGlobals.h"
 #include "Materials/MaterialInstanceConstant.h"
 #include "ComponentReregisterContext.h"
@@ -30,6 +37,8 @@
 #include "Kismet2/BlueprintEditorUtils.h"
 #include "PhysicsAssetUtils.h"
 #include "Animation/AnimSequence.h"
+#include "Animation/AnimCompress_RemoveLinearKeys.h"
+#include "Misc/ConfigCacheIni.h"
 #include "EdGraphSchema_K2_Actions.h"
 #include "Kismet2/KismetEditorUtilities.h"
 #include "K2Node_Timeline.h"
@@ -39,16 +48,28 @@
 #include "K2Node.h"
 #include "LandscapeLayerInfoObject.h"
 #include "LandscapeProxy.h"
-#include "Builders/CubeBuilder.h"
 #include "Engine/SimpleConstructionScript.h"
 #include "Engine/SCS_Node.h"
 #include "Engine/TimelineTemplate.h"
-#include "Engine/Polys.h"
-#include "Engine/BlockingVolume.h"
-#include "GameFramework/Volume.h"
-#include "Components/BrushComponent.h"
-#include "BSPOps.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "ConvexDecompTool.h"
+#include "PhysicsEngine/BodySetup.h"
+#include "Async/ParallelFor.h"
+#include "AI/NavigationSystemBase.h"
+#include "UObject/MetaData.h"
+#include "Misc/SecureHash.h"
+#include "IImageWrapper.h"
+#include "IImageWrapperModule.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonWriter.h"
+#include "Serialization/JsonSerializer.h"
 #include "Landscape.h"
+#include "Engine/LODActor.h"
+#include "GameFramework/WorldSettings.h"
+#include "HierarchicalLODUtilitiesModule.h"
+#include "IHierarchicalLODUtilities.h"
+#include "TickableEditorObject.h"
 #include "LandscapeInfo.h"
 
 #include "Common.h"
@@ -60,6 +81,12 @@
 #include "Him.h"
 #include "Ifo.h"
 #include "Til.h"
+#include "Lit.h"
+#include "Zon.h"
+#include "Stb.h"
+#include "RoseImportStats.h"
+#include "RoseImportGraph.h"
+#include "RoseImportSaver.h"
 
 static const FName RoseImportTabName("RoseImport");
 
@@ -126,7 +153,7 @@ void RefreshCollisionChange(const UStaticMesh* StaticMesh)
 	FEditorSupportDelegates::RedrawAllViewports.Broadcast();
 }
 
-void BuildAssetPath(FString& PackageName, FString& AssetName, const FString& RosePath, const FString& Postfix = TEXT(""))
+void SplitAssetPath(FString& PackageName, FString& AssetName, const FString& RosePath)
 {
 	FString NormPath = RosePath.ToUpper();
 	FPaths::NormalizeFilename(NormPath);
@@ -135,9 +162,6 @@ void BuildAssetPath(FString& PackageName, FString& AssetName, const FString& Ros
 	FString FileName = PathParts.Pop();
 
 	AssetName = FPaths::GetBaseFilename(FileName);
-	if (!Postfix.IsEmpty()) {
-		AssetName.Append(Postfix);
-	}
 
 	if (PathParts.Num() <= 0) {
 		UE_DEBUG_BREAK();
@@ -157,13 +181,259 @@ void BuildAssetPath(FString& PackageName, FString& AssetName, const FString& Ros
 	PackageName = FString(TEXT("/")) + FString::Join(PathParts, TEXT("/"));
 }
 
+typedef int32 RosePathHandle;
+
+// Package and asset names for ROSE source paths, split once per distinct path and then shared through handles
+class RosePathTable {
+public:
+	RosePathHandle Intern(const FString& RosePath) {
+		// FString keys hash and compare case-insensitively, the same way the client's paths resolve
+		const RosePathHandle* Existing = lookup.Find(RosePath);
+		if (Existing) {
+			return *Existing;
+		}
+
+		Entry entry;
+		entry.sourcePath = RosePath;
+		SplitAssetPath(entry.packageName, entry.baseName, RosePath);
+		RosePathHandle Handle = entries.Add(entry);
+		lookup.Add(RosePath, Handle);
+		return Handle;
+	}
+
+	TArray<RosePathHandle> InternAll(const TArray<FString>& RosePaths) {
+		TArray<RosePathHandle> Handles;
+		Handles.Reserve(RosePaths.Num());
+		for (const FString& RosePath : RosePaths) {
+			Handles.Add(Intern(RosePath));
+		}
+		return Handles;
+	}
+
+	const FString& GetSourcePath(RosePathHandle Handle) const {
+		return entries[Handle].sourcePath;
+	}
+
+	const FString& GetPackageName(RosePathHandle Handle) const {
+		return entries[Handle].packageName;
+	}
+
+	void GetAssetPath(RosePathHandle Handle, FString& PackageName, FString& AssetName, const TCHAR* Postfix = TEXT("")) const {
+		const Entry& entry = entries[Handle];
+		PackageName = entry.packageName;
+		AssetName = entry.baseName;
+		AssetName += Postfix;
+	}
+
+private:
+	struct Entry {
+		FString sourcePath;
+		FString packageName;
+		FString baseName;
+	};
+
+	TArray<Entry> entries;
+	TMap<FString, RosePathHandle> lookup;
+};
+
+RosePathTable& GetPathTable() {
+	static RosePathTable Table;
+	return Table;
+}
+
+void BuildAssetPath(FString& PackageName, FString& AssetName, const FString& RosePath, const FString& Postfix = TEXT(""))
+{
+	RosePathTable& Table = GetPathTable();
+	Table.GetAssetPath(Table.Intern(RosePath), PackageName, AssetName, *Postfix);
+}
+
+// Handles for the meshes and textures of a ZSC, interned once when the list is loaded
+struct ZscPaths {
+	ZscPaths() {}
+	ZscPaths(const Zsc& zsc) {
+		RosePathTable& Table = GetPathTable();
+		meshes = Table.InternAll(zsc.meshes);
+		textures.Reserve(zsc.textures.Num());
+		for (const Zsc::Texture& tex : zsc.textures) {
+			textures.Add(Table.Intern(tex.filePath));
+		}
+	}
+
+	TArray<RosePathHandle> meshes;
+	TArray<RosePathHandle> textures;
+};
+
+// Every asset under RosePackageName, listed once per import from the asset registry and kept up to date as the
+// importer creates more. Lookups are a map probe, assets are only loaded the first time they are actually used.
+class RoseAssetCache {
+public:
+	RoseAssetCache() : populated(false) {}
+
+	void Populate() {
+		assets.Reset();
+
+		IAssetRegistry& AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>("AssetRegistry").Get();
+
+		// The registry may still be discovering files, and GetOrMakePackage trusts this list to know what is on disk
+		TArray<FString> ScanPaths;
+		ScanPaths.Add(RosePackageName);
+		AssetRegistry.ScanPathsSynchronous(ScanPaths);
+
+		TArray<FAssetData> Found;
+		AssetRegistry.GetAssetsByPath(FName(*RosePackageName), Found, true);
+		for (const FAssetData& AssetData : Found) {
+			assets.Add(AssetData.ObjectPath, Entry(AssetData));
+		}
+		populated = true;
+
+		UE_LOG(LogTemp, Log, TEXT("Asset cache found %d existing assets"), assets.Num());
+	}
+
+	void Add(UObject* Asset) {
+		Entry& entry = assets.FindOrAdd(FName(*Asset->GetPathName()));
+		entry.object = Asset;
+	}
+
+	// False only when the import root is listed and nothing there or created since has this path
+	bool MayExist(const FString& ObjectPath) const {
+		return !populated || assets.Contains(FName(*ObjectPath));
+	}
+
+	template<typename T>
+	T* Find(const FString& ObjectPath) {
+		if (!populated) {
+			// Nothing listed the assets up front, fall back to searching for the package
+			return LoadObject<T>(NULL, *ObjectPath);
+		}
+
+		Entry* entry = assets.Find(FName(*ObjectPath));
+		if (entry == NULL) {
+			return NULL;
+		}
+		if (!entry->object.IsValid()) {
+			entry->object = entry->data.GetAsset();
+		}
+		return Cast<T>(entry->object.Get());
+	}
+
+private:
+	struct Entry {
+		Entry() {}
+		Entry(const FAssetData& _data) : data(_data) {}
+
+		FAssetData data;
+		TWeakObjectPtr<UObject> object;
+	};
+
+	bool populated;
+	TMap<FName, Entry> assets;
+};
+
+RoseAssetCache& GetAssetCache() {
+	static RoseAssetCache Cache;
+	return Cache;
+}
+
+// Textures by the SHA1 of their source file, so identical files under different paths share one asset. A duplicate
+// never gets an asset of its own to be found by name, so the hashes are kept in Saved/RoseImport between imports.
+class TextureContentCache {
+public:
+	void Load() {
+		byHash.Reset();
+		byPath.Reset();
+
+		FString Text;
+		TSharedPtr<FJsonObject> Root;
+		if (!FFileHelper::LoadFileToString(Text, *GetIndexPath()) || !FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(Text), Root) || !Root.IsValid()) {
+			return;
+		}
+		for (const auto& Pair : Root->Values) {
+			FSHAHash Hash;
+			Hash.FromString(Pair.Key);
+			byHash.Add(Hash, Pair.Value->AsString());
+		}
+	}
+
+	void Save() const {
+		TSharedRef<FJsonObject> Root = MakeShared<FJsonObject>();
+		for (const auto& Pair : byHash) {
+			Root->SetStringField(Pair.Key.ToString(), Pair.Value);
+		}
+
+		FString Text;
+		FJsonSerializer::Serialize(Root, TJsonWriterFactory<>::Create(&Text));
+		FFileHelper::SaveStringToFile(Text, *GetIndexPath());
+	}
+
+	// A source path already resolved this session, so it is not read and hashed again
+	UTexture* FindByPath(const FString& SourcePath) const {
+		const TWeakObjectPtr<UTexture>* Texture = byPath.Find(SourcePath);
+		return Texture ? Texture->Get() : NULL;
+	}
+
+	UTexture* Find(const FSHAHash& Hash) {
+		const FString* ObjectPath = byHash.Find(Hash);
+		if (ObjectPath == NULL) {
+			return NULL;
+		}
+
+		UTexture* Texture = GetAssetCache().Find<UTexture>(*ObjectPath);
+		if (Texture == NULL) {
+			// Deleted since the hash was recorded
+			byHash.Remove(Hash);
+		}
+		return Texture;
+	}
+
+	void Add(const FString& SourcePath, const FSHAHash& Hash, UTexture* Texture) {
+		byHash.Add(Hash, Texture->GetPathName());
+		byPath.Add(SourcePath, Texture);
+	}
+
+	void AddPath(const FString& SourcePath, UTexture* Texture) {
+		byPath.Add(SourcePath, Texture);
+	}
+
+private:
+	static FString GetIndexPath() {
+		return FPaths::ProjectSavedDir() / TEXT("RoseImport/TextureContent.json");
+	}
+
+	TMap<FSHAHash, FString> byHash;
+	TMap<FString, TWeakObjectPtr<UTexture>> byPath;
+};
+
+TextureContentCache& GetTextureContentCache() {
+	static TextureContentCache Cache;
+	return Cache;
+}
+
+// Only set while an import that saves its own packages is running
+FRoseImportSaver* ImportSaver = NULL;
+
+// Registers a newly created asset with the asset registry and the session cache
+void NotifyAssetCreated(UObject* Asset) {
+	FAssetRegistryModule::AssetCreated(Asset);
+	GetAssetCache().Add(Asset);
+	FRoseImportStats::Get().Increment(ERoseImportCounter::AssetsCreated);
+	if (ImportSaver != NULL) {
+		ImportSaver->Add(Asset->GetOutermost());
+	}
+}
+
 UPackage* GetOrMakePackage(const FString& PackageName, FString& AssetName) {
-	FAssetToolsModule& AssetToolsModule = FModuleManager::LoadModuleChecked<FAssetToolsModule>("AssetTools");
 	FString FinalPackageName;
 	FString BasePackageName = RosePackageName + PackageName / AssetName;
 	BasePackageName = PackageTools::SanitizePackageName(BasePackageName);
 
-	AssetToolsModule.Get().CreateUniqueAssetName(BasePackageName, TEXT(""), FinalPackageName, AssetName);
+	// A name the session has never seen is free, only possible clashes pay for the unique name search
+	if (FindPackage(NULL, *BasePackageName) == NULL && !GetAssetCache().MayExist(BasePackageName + TEXT(".") + AssetName)) {
+		FinalPackageName = BasePackageName;
+	}
+	else {
+		FAssetToolsModule& AssetToolsModule = FModuleManager::LoadModuleChecked<FAssetToolsModule>("AssetTools");
+		AssetToolsModule.Get().CreateUniqueAssetName(BasePackageName, TEXT(""), FinalPackageName, AssetName);
+	}
 
 	UE_LOG(LogTemp, Log, TEXT("Making Package - %s, %s, %s, %s"), *RosePackageName, *PackageName, *AssetName, *BasePackageName, *FinalPackageName);
 
@@ -181,23 +451,63 @@ T* GetExistingAsset(const FString& PackageName, const FString& AssetName) {
 	BasePackageName = PackageTools::SanitizePackageName(BasePackageName);
 	BasePackageName.Append(TEXT("."));
 	BasePackageName.Append(AssetName);
-	T* ExistingAsset = LoadObject<T>(NULL, *BasePackageName);
+	T* ExistingAsset = GetAssetCache().Find<T>(BasePackageName);
 	if (ExistingAsset) {
+		FRoseImportStats::Get().Increment(ERoseImportCounter::CacheHits);
 		return ExistingAsset;
 	}
 	return NULL;
 }
 
+template<typename ParsedType> struct RoseParsePhase;
+template<> struct RoseParsePhase<Zms> { static const ERoseImportPhase::Type Phase = ERoseImportPhase::ParseZms; };
+template<> struct RoseParsePhase<Zmo> { static const ERoseImportPhase::Type Phase = ERoseImportPhase::ParseZmo; };
+template<> struct RoseParsePhase<Zsc> { static const ERoseImportPhase::Type Phase = ERoseImportPhase::ParseZsc; };
+template<> struct RoseParsePhase<Zmd> { static const ERoseImportPhase::Type Phase = ERoseImportPhase::ParseZmd; };
+template<> struct RoseParsePhase<Chr> { static const ERoseImportPhase::Type Phase = ERoseImportPhase::ParseChr; };
+template<> struct RoseParsePhase<Ifo> { static const ERoseImportPhase::Type Phase = ERoseImportPhase::ParseIfo; };
+template<> struct RoseParsePhase<Him> { static const ERoseImportPhase::Type Phase = ERoseImportPhase::ParseHim; };
+template<> struct RoseParsePhase<Til> { static const ERoseImportPhase::Type Phase = ERoseImportPhase::ParseTil; };
+template<> struct RoseParsePhase<Lit> { static const ERoseImportPhase::Type Phase = ERoseImportPhase::ParseLit; };
+template<> struct RoseParsePhase<Zon> { static const ERoseImportPhase::Type Phase = ERoseImportPhase::ParseZon; };
+template<> struct RoseParsePhase<Stb> { static const ERoseImportPhase::Type Phase = ERoseImportPhase::ParseStb; };
+
+// Parses a file relative to RoseBasePath, timed under the phase of its format. Safe on any thread, a file the
+// parser rejects is logged and still returned with whatever it read before the error.
+template<typename ParsedType>
+TSharedPtr<ParsedType> ParseRoseFile(const FString& RosePath) {
+	FRoseImportPhaseScope Scope(RoseParsePhase<ParsedType>::Phase);
+	const FString FullPath = RoseBasePath + RosePath;
+	FRoseImportStats::Get().CountFile(FullPath);
+
+	TSharedPtr<ParsedType> Parsed = MakeShared<ParsedType>(*FullPath);
+	if (Parsed->GetError().IsSet()) {
+		FRoseImportStats::Get().Increment(ERoseImportCounter::ParseErrors);
+		UE_LOG(LogTemp, Warning, TEXT("%s: %s"), *RosePath, *Parsed->GetError().ToString());
+	}
+	return Parsed;
+}
+
+// Whether a parsed file can be used, one the parser rejected is treated as missing
+template<typename ParsedType>
+bool IsUsable(const TSharedPtr<ParsedType>& Parsed) {
+	return Parsed.IsValid() && !Parsed->GetError().IsSet();
+}
+
 UTexture* ImportTexture(const FString& PackageName, FString& AssetName, const FString& SourcePath)
 {
+	FRoseImportPhaseScope Scope(ERoseImportPhase::TextureImport);
+
 	UTexture* ExistingTexture = GetExistingAsset<UTexture>(PackageName, AssetName);
 	if (ExistingTexture != NULL) {
 		return ExistingTexture;
 	}
 
-	UPackage* Package = GetOrMakePackage(PackageName, AssetName);
-	if (Package == NULL) {
-		return NULL;
+	TextureContentCache& ContentCache = GetTextureContentCache();
+	ExistingTexture = ContentCache.FindByPath(SourcePath);
+	if (ExistingTexture != NULL) {
+		FRoseImportStats::Get().Increment(ERoseImportCounter::CacheHits);
+		return ExistingTexture;
 	}
 
 	TArray<uint8> DataBinary;
@@ -209,6 +519,21 @@ UTexture* ImportTexture(const FString& PackageName, FString& AssetName, const FS
 		return NULL;
 	}
 
+	// The same file under another name is the texture imported for it the first time
+	FSHAHash ContentHash;
+	FSHA1::HashBuffer(DataBinary.GetData(), DataBinary.Num(), ContentHash.Hash);
+	ExistingTexture = ContentCache.Find(ContentHash);
+	if (ExistingTexture != NULL) {
+		FRoseImportStats::Get().Increment(ERoseImportCounter::TextureDuplicates);
+		ContentCache.AddPath(SourcePath, ExistingTexture);
+		return ExistingTexture;
+	}
+
+	UPackage* Package = GetOrMakePackage(PackageName, AssetName);
+	if (Package == NULL) {
+		return NULL;
+	}
+
 	
 	const uint8* PtrTexture = DataBinary.GetData();
 
@@ -224,7 +549,8 @@ UTexture* ImportTexture(const FString& PackageName, FString& AssetName, const FS
 	if (Texture != NULL)
 	{
 		// Notify the asset registry
-		FAssetRegistryModule::AssetCreated(Texture);
+		NotifyAssetCreated(Texture);
+		ContentCache.Add(SourcePath, ContentHash, Texture);
 
 		// Set the dirty flag so this package will get saved later
 		Texture->MarkPackageDirty();
@@ -235,7 +561,9 @@ UTexture* ImportTexture(const FString& PackageName, FString& AssetName, const FS
 	return Texture;
 }
 
-UMaterial* GetOrMakeBaseMaterial(const Zsc::Texture& MatInfo) {
+UMaterial* GetOrMakeBaseMaterial(const Zsc::Texture& MatInfo, bool lightmapped = false) {
+	FRoseImportPhaseScope Scope(ERoseImportPhase::MaterialCreate);
+
 	FString MaterialName;
 	if (MatInfo.alphaTestEnabled) {
 		MaterialName = "AlphaRefMaterial";
@@ -251,8 +579,11 @@ UMaterial* GetOrMakeBaseMaterial(const Zsc::Texture& MatInfo) {
 		MaterialName.Append("_DS");
 	}
 
-	FString MaterialFullName = FString::Printf(TEXT("%s/%s.%s"), *RosePackageName, *MaterialName, *MaterialName);
-	UMaterial* Material = LoadObject<UMaterial>(NULL, *MaterialFullName, NULL, LOAD_None, NULL);
+	if (lightmapped) {
+		MaterialName.Append("_LM");
+	}
+
+	UMaterial* Material = GetExistingAsset<UMaterial>(TEXT("/"), MaterialName);
 	if (Material != NULL) {
 		//UE_LOG(RosePlugin, Log, TEXT("Skipped Base Creation - Found It!"));
 		return Material;
@@ -271,7 +602,7 @@ UMaterial* GetOrMakeBaseMaterial(const Zsc::Texture& MatInfo) {
 	}
 
 	// Notify the asset registry
-	FAssetRegistryModule::AssetCreated(Material);
+	NotifyAssetCreated(Material);
 
 	// Set the dirty flag so this package will get saved later
 	Material->MarkPackageDirty();
@@ -313,6 +644,63 @@ UMaterial* GetOrMakeBaseMaterial(const Zsc::Texture& MatInfo) {
 	UnrealTextureExpression->MaterialExpressionEditorX = -320;
 	UnrealTextureExpression->MaterialExpressionEditorY = 240;
 
+	if (lightmapped) {
+		// The baked lightmap already carries the lighting, so the surface is unlit texture times lightmap
+		Material->SetShadingModel(MSM_Unlit);
+
+		UMaterialExpressionTextureCoordinate* LightmapUV = NewObject<UMaterialExpressionTextureCoordinate>(Material);
+		LightmapUV->CoordinateIndex = 1;
+		Material->Expressions.Add(LightmapUV);
+
+		// Atlas cell of the part, only the RG channels of both parameters are used
+		UMaterialExpressionVectorParameter* ScaleParam = NewObject<UMaterialExpressionVectorParameter>(Material);
+		ScaleParam->ParameterName = TEXT("LightmapScale");
+		ScaleParam->DefaultValue = FLinearColor(1.0f, 1.0f, 0.0f, 0.0f);
+		Material->Expressions.Add(ScaleParam);
+		UMaterialExpressionVectorParameter* BiasParam = NewObject<UMaterialExpressionVectorParameter>(Material);
+		BiasParam->ParameterName = TEXT("LightmapBias");
+		BiasParam->DefaultValue = FLinearColor(0.0f, 0.0f, 0.0f, 0.0f);
+		Material->Expressions.Add(BiasParam);
+
+		UMaterialExpressionComponentMask* Scale = NewObject<UMaterialExpressionComponentMask>(Material);
+		Scale->R = 1;
+		Scale->G = 1;
+		Material->Expressions.Add(Scale);
+		UMaterialExpressionComponentMask* Bias = NewObject<UMaterialExpressionComponentMask>(Material);
+		Bias->R = 1;
+		Bias->G = 1;
+		Material->Expressions.Add(Bias);
+
+		UMaterialExpressionMultiply* ScaledUV = NewObject<UMaterialExpressionMultiply>(Material);
+		Material->Expressions.Add(ScaledUV);
+		UMaterialExpressionAdd* CellUV = NewObject<UMaterialExpressionAdd>(Material);
+		Material->Expressions.Add(CellUV);
+
+		UMaterialExpressionTextureSampleParameter2D* LightmapExpression = NewObject<UMaterialExpressionTextureSampleParameter2D>(Material);
+		LightmapExpression->ParameterName = TEXT("Lightmap");
+		LightmapExpression->SetDefaultTexture();
+		LightmapExpression->SamplerType = SAMPLERTYPE_Color;
+		LightmapExpression->MaterialExpressionEditorX = -320;
+		LightmapExpression->MaterialExpressionEditorY = 520;
+		Material->Expressions.Add(LightmapExpression);
+
+		UMaterialExpressionMultiply* LitColor = NewObject<UMaterialExpressionMultiply>(Material);
+		Material->Expressions.Add(LitColor);
+
+		ScaleParam->ConnectExpression(&Scale->Input, 0);
+		BiasParam->ConnectExpression(&Bias->Input, 0);
+		LightmapUV->ConnectExpression(&ScaledUV->A, 0);
+		Scale->ConnectExpression(&ScaledUV->B, 0);
+		ScaledUV->ConnectExpression(&CellUV->A, 0);
+		Bias->ConnectExpression(&CellUV->B, 0);
+		CellUV->ConnectExpression(&LightmapExpression->Coordinates, 0);
+		UnrealTextureExpression->ConnectExpression(&LitColor->A, 0);
+		LightmapExpression->ConnectExpression(&LitColor->B, 0);
+
+		Material->BaseColor.Expression = NULL;
+		LitColor->ConnectExpression(&Material->EmissiveColor, 0);
+	}
+
 	Material->bUsedWithSkeletalMesh = true;
 
 	Material->PostEditChange();
@@ -321,6 +709,8 @@ UMaterial* GetOrMakeBaseMaterial(const Zsc::Texture& MatInfo) {
 }
 
 UMaterialInterface* ImportMaterial(const FString& PackageName, FString& MaterialName, const Zsc::Texture& TexData, UTexture* Texture) {
+	FRoseImportPhaseScope Scope(ERoseImportPhase::MaterialCreate);
+
 	UPackage* Package = GetOrMakePackage(PackageName, MaterialName);
 	if (Package == NULL) {
 		return NULL;
@@ -333,7 +723,7 @@ UMaterialInterface* ImportMaterial(const FString& PackageName, FString& Material
 	}
 
 	// Notify the asset registry
-	FAssetRegistryModule::AssetCreated(Material);
+	NotifyAssetCreated(Material);
 
 	// Set the dirty flag so this package will get saved later
 	Material->MarkPackageDirty();
@@ -361,126 +751,168 @@ UMaterialInterface* ImportMaterial(const FString& PackageName, FString& Material
 	return Material;
 }
 
-struct ImportSkelData {
-	ImportSkelData(Zmd& _data, const FString& _SkelPackage, FString& _SkelName)
-		: data(_data), skeleton(0), SkelPackage(_SkelPackage), SkelName(_SkelName) {}
-	Zmd& data;
+// A part placed with a baked ROSE lightmap, ScaleBias comes from Lit::Part::GetScaleBias
+UMaterialInterface* ImportLightmapMaterial(const FString& PackageName, FString& MaterialName, const Zsc::Texture& TexData, UTexture* Texture, UTexture* Lightmap, const FVector4& ScaleBias) {
+	FRoseImportPhaseScope Scope(ERoseImportPhase::MaterialCreate);
 
-	USkeleton* skeleton;
-	const FString& SkelPackage;
-	FString& SkelName;
-};
+	UMaterialInterface* ExistingMaterial = GetExistingAsset<UMaterialInterface>(PackageName, MaterialName);
+	if (ExistingMaterial != NULL) {
+		return ExistingMaterial;
+	}
 
-struct ImportMeshData {
-	struct Item {
-		Item(Zms& _data, uint32 _matIdx)
-			: data(_data), matIdx(_matIdx),
-			vertOffset(0), indexOffset(0), faceOffset(0) {}
+	UPackage* Package = GetOrMakePackage(PackageName, MaterialName);
+	if (Package == NULL) {
+		return NULL;
+	}
 
-		Zms& data;
-		uint32 matIdx;
+	UMaterialInstanceConstant* Material = NewObject<UMaterialInstanceConstant>(Package, *MaterialName, RF_Standalone | RF_Public);
+	if (Material == NULL) {
+		return NULL;
+	}
 
-		uint32 vertOffset;
-		uint32 indexOffset;
-		uint32 faceOffset;
-	};
+	NotifyAssetCreated(Material);
+	Material->MarkPackageDirty();
 
-	TArray<Item> meshes;
-	TArray<UMaterialInterface*> materials;
-};
+	UMaterial* BaseMaterial = GetOrMakeBaseMaterial(TexData, true);
 
-USkeleton* ApplySkeletonToMesh(const FString& PackageName, FString& SkeletonName, USkeletalMesh* Mesh, ImportSkelData& skelData) {
-	FReferenceSkeleton& RefSkeleton = Mesh->RefSkeleton;
-	FReferenceSkeletonModifier modifier(RefSkeleton, Mesh->Skeleton);
+	Material->PreEditChange(NULL);
 
-	for (int i = 0; i < skelData.data.bones.Num(); ++i) {
-		const Zmd::Bone& bone = skelData.data.bones[i];
+	Material->SetParentEditorOnly(BaseMaterial);
+	Material->SetTextureParameterValueEditorOnly(TEXT("Texture"), Texture);
+	Material->SetTextureParameterValueEditorOnly(TEXT("Lightmap"), Lightmap);
+	Material->SetVectorParameterValueEditorOnly(TEXT("LightmapScale"), FLinearColor(ScaleBias.X, ScaleBias.Y, 0.0f, 0.0f));
+	Material->SetVectorParameterValueEditorOnly(TEXT("LightmapBias"), FLinearColor(ScaleBias.Z, ScaleBias.W, 0.0f, 0.0f));
 
-		int32 ueParent = (i > 0) ? bone.parent : INDEX_NONE;
-		const FMeshBoneInfo BoneInfo(FName(bone.name, FNAME_Add), bone.name, ueParent);
-		const FTransform BoneTransform(bone.rotation, bone.translation);
-		modifier.Add(BoneInfo, BoneTransform);
+	if (TexData.alphaTestEnabled && TexData.alphaReference != 128) {
+		Material->BasePropertyOverrides.bOverride_OpacityMaskClipValue = true;
+		Material->BasePropertyOverrides.OpacityMaskClipValue = (float)TexData.alphaReference / 255.0f;
 	}
 
-	Mesh->CalculateInvRefMatrices();
+	Material->PostEditChange();
 
-	if (!skelData.skeleton) {
-		UPackage* Package = GetOrMakePackage(PackageName, SkeletonName);
-		if (Package == NULL) {
-			return NULL;
-		}
+	return Material;
+}
 
-		USkeleton* Skeleton = CastChecked<USkeleton>(NewObject<USkeleton>());
-		if (Skeleton == NULL) {
-			return NULL;
-		}
+struct ImportSkelData {
+	ImportSkelData(const FString& ZmdPath)
+		: data(*(RoseBasePath + ZmdPath)), skeleton(0) {
+		BuildAssetPath(SkelPackage, SkelName, ZmdPath, TEXT("_Skeleton"));
+		ZmdName = FPaths::GetBaseFilename(ZmdPath).ToUpper();
+	}
+	Zmd data;
 
-		// Notify the asset registry
-		FAssetRegistryModule::AssetCreated(Skeleton);
+	USkeleton* skeleton;
+	FString SkelPackage;
+	FString SkelName;
+	FString ZmdName;
 
-		// Set the dirty flag so this package will get saved later
-		Skeleton->MarkPackageDirty();
+	// Animations already imported against this skeleton, keyed by normalized ZMO path
+	TMap<FString, UAnimSequence*> anims;
+};
 
-		skelData.skeleton = Skeleton;
-	}
+class SkeletonCache {
+public:
+	// Returns the one shared skeleton for a ZMD, parsing it the first time it is referenced
+	ImportSkelData& Get(const FString& ZmdPath) {
+		FString Key = ZmdPath.ToUpper();
+		FPaths::NormalizeFilename(Key);
+
+		TUniquePtr<ImportSkelData>* Existing = skeletons.Find(Key);
+		if (Existing) {
+			FRoseImportStats::Get().Increment(ERoseImportCounter::CacheHits);
+			return **Existing;
+		}
 
-	if (skelData.skeleton) {
-		skelData.skeleton->MergeAllBonesToBoneTree(Mesh);
+		ImportSkelData* skelData;
+		{
+			FRoseImportPhaseScope Scope(ERoseImportPhase::ParseZmd);
+			FRoseImportStats::Get().CountFile(RoseBasePath + ZmdPath);
+			skelData = new ImportSkelData(ZmdPath);
+		}
+		if (skelData->data.GetError().IsSet()) {
+			FRoseImportStats::Get().Increment(ERoseImportCounter::ParseErrors);
+			UE_LOG(LogTemp, Warning, TEXT("%s: %s"), *ZmdPath, *skelData->data.GetError().ToString());
+		}
+		skelData->skeleton = GetExistingAsset<USkeleton>(skelData->SkelPackage, skelData->SkelName);
+		skeletons.Add(Key, TUniquePtr<ImportSkelData>(skelData));
+		return *skelData;
 	}
 
-	return Mesh->Skeleton;
-}
+private:
+	TMap<FString, TUniquePtr<ImportSkelData>> skeletons;
+};
 
-USkeletalMesh* ImportSkeletalMesh(const FString& PackageName, FString& MeshName, ImportMeshData meshData, ImportSkelData& skelData) {
-	UPackage* Package = GetOrMakePackage(PackageName, MeshName);
-	if (Package == NULL) {
-		return NULL;
-	}
+struct ImportMeshData {
+	struct Item {
+		Item(const TSharedPtr<Zms>& _data, uint32 _matIdx)
+			: data(_data), matIdx(_matIdx) {}
 
-	USkeletalMesh* SkeletalMesh = CastChecked<USkeletalMesh>(NewObject<USkeletalMesh>());
-	//StaticConstructObject(USkeletalMesh::StaticClass(), Package, *MeshName, RF_Standalone | RF_Public));
-	if (SkeletalMesh == NULL) {
-		return NULL;
+		TSharedPtr<Zms> data;
+		uint32 matIdx;
+	};
+
+	TArray<Item> meshes;
+	TArray<UMaterialInterface*> materials;
+};
+
+struct PreparedSkeletalMesh {
+	PreparedSkeletalMesh() : lodModel(0), hasNormals(true), hasTangents(true), succeeded(false) {}
+	~PreparedSkeletalMesh() {
+		delete lodModel;
 	}
 
-	// Notify the asset registry
-	FAssetRegistryModule::AssetCreated(SkeletalMesh);
+	FReferenceSkeleton refSkeleton;
+	FSkeletalMeshLODModel* lodModel;
+	bool hasNormals;
+	bool hasTangents;
+	bool succeeded;
+	TArray<FText> warnings;
 
-	// Set the dirty flag so this package will get saved later
-	SkeletalMesh->MarkPackageDirty();
+private:
+	PreparedSkeletalMesh(const PreparedSkeletalMesh&) = delete;
+	PreparedSkeletalMesh& operator=(const PreparedSkeletalMesh&) = delete;
+};
 
-	SkeletalMesh->PreEditChange(NULL);
+void BuildRefSkeleton(const Zmd& zmd, FReferenceSkeleton& RefSkeleton) {
+	FReferenceSkeletonModifier modifier(RefSkeleton, NULL);
 
-	for (int i = 0; i < meshData.materials.Num(); ++i) {
-		SkeletalMesh->Materials.Add(FSkeletalMaterial(meshData.materials[i]));
-	}
+	for (int i = 0; i < zmd.bones.Num(); ++i) {
+		const Zmd::Bone& bone = zmd.bones[i];
 
-	FString SkeletonName = MeshName + "_Skeleton";
-	USkeleton* Skeleton = ApplySkeletonToMesh(PackageName, SkeletonName, SkeletalMesh, skelData);
-	if (Skeleton == NULL) {
-		return NULL;
+		int32 ueParent = (i > 0) ? bone.parent : INDEX_NONE;
+		const FMeshBoneInfo BoneInfo(FName(*bone.name, FNAME_Add), bone.name, ueParent);
+		const FTransform BoneTransform(bone.rotation, bone.translation);
+		modifier.Add(BoneInfo, BoneTransform);
 	}
+}
 
-	FSkeletalMeshModel* ImportedResource = SkeletalMesh->GetImportedModel(); //SkeletalMesh->GetImportedResource();
-	check(ImportedResource->LODModels.Num() == 0);
-	ImportedResource->LODModels.Empty();
-	//new(ImportedResource->LODModels)FStaticLODModel();
-
-	SkeletalMesh->GetLODInfoArray().Empty();
-	SkeletalMesh->GetLODInfoArray().AddZeroed();
-	SkeletalMesh->GetLODInfoArray()[0].LODHysteresis = 0.02f;
-	FSkeletalMeshOptimizationSettings Settings;
-	// set default reduction settings values
-	SkeletalMesh->GetLODInfoArray()[0].ReductionSettings = Settings;
+// Direction V grows in across a face, zero when the face has no usable UVs
+FVector GetFaceUvBitangent(const FVector (&Positions)[3], const FVector2D (&Uvs)[3]) {
+	FVector Edge1 = Positions[1] - Positions[0];
+	FVector Edge2 = Positions[2] - Positions[0];
+	FVector2D Delta1 = Uvs[1] - Uvs[0];
+	FVector2D Delta2 = Uvs[2] - Uvs[0];
+	float Det = Delta1.X * Delta2.Y - Delta2.X * Delta1.Y;
+	if (FMath::IsNearlyZero(Det)) {
+		return FVector::ZeroVector;
+	}
+	return (Edge2 * Delta1.X - Edge1 * Delta2.X) / Det;
+}
 
-	SkeletalMesh->bHasVertexColors = false;
+// ZMS tangents carry no handedness, the bitangent takes its sign from the UV layout of the face
+FVector GetWedgeBitangent(const FVector& Normal, const FVector& Tangent, const FVector& FaceBitangent) {
+	FVector Bitangent = (Normal ^ Tangent).GetSafeNormal();
+	return (Bitangent | FaceBitangent) < 0.0f ? -Bitangent : Bitangent;
+}
 
-	FSkeletalMeshLODModel& LODModel = (FSkeletalMeshLODModel&)ImportedResource->LODModels[0];
-	LODModel.NumTexCoords = 1;
+// Builds the render data for a skeletal mesh without touching any UObject, safe to run on worker threads
+void PrepareSkeletalMesh(IMeshUtilities& MeshUtilities, const ImportMeshData& meshData, const Zmd& zmd, PreparedSkeletalMesh& prepared) {
+	FRoseImportPhaseScope Scope(ERoseImportPhase::MeshBuild);
 
-	IMeshUtilities& MeshUtilities = FModuleManager::Get().LoadModuleChecked<IMeshUtilities>("MeshUtilities");
+	BuildRefSkeleton(zmd, prepared.refSkeleton);
 
-	auto meshList = meshData.meshes;
+	// Items are only read here, shared Zms pointers must not be copied off the game thread
+	const TArray<ImportMeshData::Item>& meshList = meshData.meshes;
 
 	TArray<FVector> LODPoints;
 	TArray<SkeletalMeshImportData::FMeshWedge> LODWedges;
@@ -488,128 +920,223 @@ USkeletalMesh* ImportSkeletalMesh(const FString& PackageName, FString& MeshName,
 	TArray<SkeletalMeshImportData::FVertInfluence> LODInfluences;
 	TArray<int32> LODPointToRawMap;
 
+	TArray<int32> vertOffsets, indexOffsets, faceOffsets;
+	vertOffsets.SetNum(meshList.Num());
+	indexOffsets.SetNum(meshList.Num());
+	faceOffsets.SetNum(meshList.Num());
+
 	int32 totalVertCount = 0;
 	int32 totalIndexCount = 0;
 	int32 totalFaceCount = 0;
 	for (int i = 0; i < meshList.Num(); ++i) {
-		meshList[i].vertOffset = totalVertCount;
-		meshList[i].indexOffset = totalIndexCount;
-		meshList[i].faceOffset = totalFaceCount;
-		totalVertCount += meshList[i].data.vertexPositions.Num();
-		totalIndexCount += meshList[i].data.indexes.Num();
-		totalFaceCount += meshList[i].data.indexes.Num() / 3;
+		vertOffsets[i] = totalVertCount;
+		indexOffsets[i] = totalIndexCount;
+		faceOffsets[i] = totalFaceCount;
+		totalVertCount += meshList[i].data->vertexPositions.Num();
+		totalIndexCount += meshList[i].data->indexes.Num();
+		totalFaceCount += meshList[i].data->indexes.Num() / 3;
 	}
+	FRoseImportStats::Get().Increment(ERoseImportCounter::Triangles, totalFaceCount);
 
 	LODPoints.AddZeroed(totalVertCount);
 	LODPointToRawMap.AddZeroed(totalVertCount);
 	LODWedges.AddZeroed(totalIndexCount);
 	LODFaces.AddZeroed(totalFaceCount);
+	LODInfluences.Reserve(totalVertCount * 4);
 
-	bool hasNormals = true;
-
+	prepared.hasNormals = true;
+	prepared.hasTangents = true;
 	for (int i = 0; i < meshList.Num(); ++i) {
-		Zms& tmesh = meshList[i].data;
-
-		if (tmesh.vertexNormals.Num() == 0) {
-			hasNormals = false;
+		if (meshList[i].data->vertexNormals.Num() == 0) {
+			prepared.hasNormals = false;
 		}
+		if (meshList[i].data->vertexTangents.Num() == 0) {
+			prepared.hasTangents = false;
+		}
+	}
+	prepared.hasTangents &= prepared.hasNormals;
+
+	for (int i = 0; i < meshList.Num(); ++i) {
+		const Zms& tmesh = *meshList[i].data;
 
 		for (int j = 0; j < tmesh.vertexPositions.Num(); ++j) {
-			int32 vertIdx = meshList[i].vertOffset + j;
+			int32 vertIdx = vertOffsets[i] + j;
 			LODPoints[vertIdx] = tmesh.vertexPositions[j];
 			LODPointToRawMap[vertIdx] = vertIdx;
 		}
 
 		for (int j = 0; j < tmesh.indexes.Num(); ++j) {
-			int32 wedgeIdx = meshList[i].indexOffset + j;
-			LODWedges[wedgeIdx].iVertex = meshList[i].vertOffset + tmesh.indexes[j];
-			LODWedges[wedgeIdx].UVs[0] = tmesh.vertexUvs[0][tmesh.indexes[j]];
-
-			if (LODWedges[wedgeIdx].iVertex >= (uint32)totalVertCount) {
-				UE_DEBUG_BREAK();
+			int32 wedgeIdx = indexOffsets[i] + j;
+			if (tmesh.indexes[j] >= (uint32)tmesh.vertexPositions.Num()) {
+				return;
+			}
+			LODWedges[wedgeIdx].iVertex = vertOffsets[i] + tmesh.indexes[j];
+			if (tmesh.vertexUvs[0].Num() > 0) {
+				LODWedges[wedgeIdx].UVs[0] = tmesh.vertexUvs[0][tmesh.indexes[j]];
 			}
 		}
 
 		int32 faceCount = tmesh.indexes.Num() / 3;
 		for (int j = 0; j < faceCount; ++j) {
-			int32 faceIdx = meshList[i].faceOffset + j;
-			LODFaces[faceIdx].iWedge[0] = meshList[i].indexOffset + (j * 3 + 0);
-			LODFaces[faceIdx].iWedge[1] = meshList[i].indexOffset + (j * 3 + 1);
-			LODFaces[faceIdx].iWedge[2] = meshList[i].indexOffset + (j * 3 + 2);
-			if (hasNormals) {
-				LODFaces[faceIdx].TangentZ[0] = tmesh.vertexNormals[tmesh.indexes[j * 3 + 0]];
-				LODFaces[faceIdx].TangentZ[1] = tmesh.vertexNormals[tmesh.indexes[j * 3 + 1]];
-				LODFaces[faceIdx].TangentZ[2] = tmesh.vertexNormals[tmesh.indexes[j * 3 + 2]];
+			int32 faceIdx = faceOffsets[i] + j;
+			LODFaces[faceIdx].iWedge[0] = indexOffsets[i] + (j * 3 + 0);
+			LODFaces[faceIdx].iWedge[1] = indexOffsets[i] + (j * 3 + 1);
+			LODFaces[faceIdx].iWedge[2] = indexOffsets[i] + (j * 3 + 2);
+			if (prepared.hasNormals) {
+				FVector Positions[3];
+				FVector2D Uvs[3];
+				for (int k = 0; k < 3; ++k) {
+					uint32 vertIdx = tmesh.indexes[j * 3 + k];
+					Positions[k] = tmesh.vertexPositions[vertIdx];
+					Uvs[k] = LODWedges[LODFaces[faceIdx].iWedge[k]].UVs[0];
+				}
+				FVector FaceBitangent = GetFaceUvBitangent(Positions, Uvs);
+
+				for (int k = 0; k < 3; ++k) {
+					uint32 vertIdx = tmesh.indexes[j * 3 + k];
+					LODFaces[faceIdx].TangentZ[k] = tmesh.vertexNormals[vertIdx];
+					if (prepared.hasTangents) {
+						LODFaces[faceIdx].TangentX[k] = tmesh.vertexTangents[vertIdx];
+						LODFaces[faceIdx].TangentY[k] = GetWedgeBitangent(tmesh.vertexNormals[vertIdx], tmesh.vertexTangents[vertIdx], FaceBitangent);
+					}
+				}
 			}
 			LODFaces[faceIdx].MeshMaterialIndex = meshList[i].matIdx;
 		}
 
-		for (int j = 0; j < tmesh.vertexPositions.Num(); ++j) {
-			int32 infBaseIdx = (meshList[i].vertOffset + j) * 4;
+		for (int j = 0; j < tmesh.boneWeights.Num(); ++j) {
 			for (int k = 0; k < 4; ++k) {
 				SkeletalMeshImportData::FVertInfluence vi;
-				vi.VertIndex = meshList[i].vertOffset + j;
+				vi.VertIndex = vertOffsets[i] + j;
 				vi.BoneIndex = tmesh.boneWeights[j].boneIdx[k];
 				vi.Weight = tmesh.boneWeights[j].weight[k];
 				if (vi.Weight < 0.0001f) {
 					continue;
 				}
-				if (vi.VertIndex >= (uint32)totalVertCount) {
-					UE_DEBUG_BREAK();
-				}
-				if (vi.BoneIndex >= skelData.data.bones.Num()) {
-					UE_DEBUG_BREAK();
+				if (vi.BoneIndex >= zmd.bones.Num()) {
+					return;
 				}
 				LODInfluences.Add(vi);
 			}
 		}
 	}
 
-	TArray<FText> WarningMessages;
-	TArray<FName> WarningNames;
-	// Create actual rendering data.
+	prepared.lodModel = new FSkeletalMeshLODModel();
+	prepared.lodModel->NumTexCoords = 1;
 
 	IMeshUtilities::MeshBuildOptions meshBuildOptions;
-	meshBuildOptions.bComputeWeightedNormals = !hasNormals;
-
-	if (!MeshUtilities.BuildSkeletalMesh(
-		ImportedResource->LODModels[0],
-		SkeletalMesh->RefSkeleton,
-		LODInfluences, 
-		LODWedges, 
-		LODFaces, 
-		LODPoints, 
+	// Whatever the ZMS files carry is used as is, only meshes missing it pay for the recomputation
+	meshBuildOptions.bComputeNormals = !prepared.hasNormals;
+	meshBuildOptions.bComputeTangents = !prepared.hasTangents;
+	meshBuildOptions.bComputeWeightedNormals = !prepared.hasNormals;
+
+	TArray<FName> WarningNames;
+	prepared.succeeded = MeshUtilities.BuildSkeletalMesh(
+		*prepared.lodModel,
+		prepared.refSkeleton,
+		LODInfluences,
+		LODWedges,
+		LODFaces,
+		LODPoints,
 		LODPointToRawMap,
 		meshBuildOptions,
-		//false, 
-		//!hasNormals, 
-		//true, 
-		&WarningMessages, 
-		&WarningNames))
-	{
-		UE_DEBUG_BREAK();
-	}
-	else if (WarningMessages.Num() > 0)
-	{
-		UE_DEBUG_BREAK();
-	}
-
-	const int32 NumSections = LODModel.Sections.Num();
-	for (int32 SectionIndex = 0; SectionIndex < NumSections; ++SectionIndex)
-	{
+		&prepared.warnings,
+		&WarningNames);
+}
 
-		//SkeletalMesh->GetLODInfoArray()[0].TriangleSortSettings.AddZeroed();
-	}
+USkeleton* ApplySkeletonToMesh(USkeletalMesh* Mesh, ImportSkelData& skelData) {
+	Mesh->CalculateInvRefMatrices();
 
+	if (!skelData.skeleton) {
+		UPackage* Package = GetOrMakePackage(skelData.SkelPackage, skelData.SkelName);
+		if (Package == NULL) {
+			return NULL;
+		}
 
-	SkeletalMesh->PostEditChange();
+		USkeleton* Skeleton = NewObject<USkeleton>(Package, *skelData.SkelName, RF_Standalone | RF_Public);
+		if (Skeleton == NULL) {
+			return NULL;
+		}
+
+		// Notify the asset registry
+		NotifyAssetCreated(Skeleton);
+
+		// Set the dirty flag so this package will get saved later
+		Skeleton->MarkPackageDirty();
+
+		skelData.skeleton = Skeleton;
+	}
+
+	// Every mesh built from the same ZMD shares the same bone tree
+	skelData.skeleton->MergeAllBonesToBoneTree(Mesh);
+	Mesh->Skeleton = skelData.skeleton;
+
+	return Mesh->Skeleton;
+}
+
+// Wraps prepared render data into a skeletal mesh asset, must run on the game thread
+USkeletalMesh* FinishSkeletalMesh(const FString& PackageName, FString& MeshName, const ImportMeshData& meshData, ImportSkelData& skelData, PreparedSkeletalMesh& prepared) {
+	FRoseImportPhaseScope Scope(ERoseImportPhase::MeshBuild);
+
+	if (!prepared.succeeded) {
+		UE_LOG(LogTemp, Error, TEXT("Failed to build skeletal mesh - %s"), *MeshName);
+		return NULL;
+	}
+	for (int i = 0; i < prepared.warnings.Num(); ++i) {
+		UE_LOG(LogTemp, Warning, TEXT("Skeletal mesh %s - %s"), *MeshName, *prepared.warnings[i].ToString());
+	}
+
+	UPackage* Package = GetOrMakePackage(PackageName, MeshName);
+	if (Package == NULL) {
+		return NULL;
+	}
+
+	USkeletalMesh* SkeletalMesh = NewObject<USkeletalMesh>(Package, *MeshName, RF_Standalone | RF_Public);
+	if (SkeletalMesh == NULL) {
+		return NULL;
+	}
+
+	// Notify the asset registry
+	NotifyAssetCreated(SkeletalMesh);
+
+	// Set the dirty flag so this package will get saved later
+	SkeletalMesh->MarkPackageDirty();
+
+	SkeletalMesh->PreEditChange(NULL);
+
+	for (int i = 0; i < meshData.materials.Num(); ++i) {
+		SkeletalMesh->Materials.Add(FSkeletalMaterial(meshData.materials[i]));
+	}
+
+	SkeletalMesh->RefSkeleton = prepared.refSkeleton;
+	USkeleton* Skeleton = ApplySkeletonToMesh(SkeletalMesh, skelData);
+	if (Skeleton == NULL) {
+		return NULL;
+	}
+
+	FSkeletalMeshModel* ImportedResource = SkeletalMesh->GetImportedModel(); //SkeletalMesh->GetImportedResource();
+	check(ImportedResource->LODModels.Num() == 0);
+	ImportedResource->LODModels.Empty();
+	ImportedResource->LODModels.Add(prepared.lodModel);
+	prepared.lodModel = NULL;
+
+	SkeletalMesh->GetLODInfoArray().Empty();
+	SkeletalMesh->GetLODInfoArray().AddZeroed();
+	SkeletalMesh->GetLODInfoArray()[0].LODHysteresis = 0.02f;
+	FSkeletalMeshOptimizationSettings Settings;
+	// set default reduction settings values
+	SkeletalMesh->GetLODInfoArray()[0].ReductionSettings = Settings;
+
+	SkeletalMesh->bHasVertexColors = false;
+
+	SkeletalMesh->PostEditChange();
 
 	FString PhysName = MeshName + "_PhysicsAsset";
-	UPhysicsAsset* PhysicsAsset = CastChecked<UPhysicsAsset>(NewObject<UPhysicsAsset>());
-	//StaticConstructObject(UPhysicsAsset::StaticClass(), Package, *PhysName, RF_Standalone | RF_Public));
+	UPackage* PhysPackage = GetOrMakePackage(PackageName, PhysName);
+	UPhysicsAsset* PhysicsAsset = PhysPackage ? NewObject<UPhysicsAsset>(PhysPackage, *PhysName, RF_Standalone | RF_Public) : NULL;
 	if (PhysicsAsset) {
 		// Notify the asset registry
-		FAssetRegistryModule::AssetCreated(PhysicsAsset);
+		NotifyAssetCreated(PhysicsAsset);
 
 		// Set the dirty flag so this package will get saved later
 		PhysicsAsset->MarkPackageDirty();
@@ -618,26 +1145,109 @@ USkeletalMesh* ImportSkeletalMesh(const FString& PackageName, FString& MeshName,
 		FPhysAssetCreateParams NewBodyData;
 		// NewBodyData.Initialize();
 		FText CreationErrorMessage;
-		FPhysicsAssetUtils::CreateFromSkeletalMesh(PhysicsAsset, SkeletalMesh, NewBodyData, CreationErrorMessage);
+		if (FPhysicsAssetUtils::CreateFromSkeletalMesh(PhysicsAsset, SkeletalMesh, NewBodyData, CreationErrorMessage)) {
+			SkeletalMesh->PhysicsAsset = PhysicsAsset;
+		}
 	}
 
-	return NULL;
+	return SkeletalMesh;
+}
+
+USkeletalMesh* ImportSkeletalMesh(const FString& PackageName, FString& MeshName, const ImportMeshData& meshData, ImportSkelData& skelData) {
+	IMeshUtilities& MeshUtilities = FModuleManager::Get().LoadModuleChecked<IMeshUtilities>("MeshUtilities");
+
+	PreparedSkeletalMesh prepared;
+	PrepareSkeletalMesh(MeshUtilities, meshData, skelData.data, prepared);
+	return FinishSkeletalMesh(PackageName, MeshName, meshData, skelData, prepared);
+}
+
+// Defaults for a set of imported animations, overridden per set from [RoseImport.AnimCompression.<SetName>] in
+// the editor per project ini, e.g. PositionTolerance=0.05
+struct AnimCompressSettings {
+	AnimCompressSettings(const FString& _SetName)
+		: SetName(_SetName),
+		positionTolerance(0.01f), rotationTolerance(0.000001f), scaleTolerance(0.0001f),
+		stripBindPoseTracks(true),
+		maxPosDiff(0.1f), maxAngleDiff(0.025f), maxScaleDiff(0.00001f) {
+		const FString Section = TEXT("RoseImport.AnimCompression.") + SetName;
+		GConfig->GetFloat(*Section, TEXT("PositionTolerance"), positionTolerance, GEditorPerProjectIni);
+		GConfig->GetFloat(*Section, TEXT("RotationTolerance"), rotationTolerance, GEditorPerProjectIni);
+		GConfig->GetFloat(*Section, TEXT("ScaleTolerance"), scaleTolerance, GEditorPerProjectIni);
+		GConfig->GetBool(*Section, TEXT("StripBindPoseTracks"), stripBindPoseTracks, GEditorPerProjectIni);
+		GConfig->GetFloat(*Section, TEXT("MaxPosDiff"), maxPosDiff, GEditorPerProjectIni);
+		GConfig->GetFloat(*Section, TEXT("MaxAngleDiff"), maxAngleDiff, GEditorPerProjectIni);
+		GConfig->GetFloat(*Section, TEXT("MaxScaleDiff"), maxScaleDiff, GEditorPerProjectIni);
+	}
+
+	FString SetName;
+
+	// Channels whose keys all stay within these of the first key collapse to a single key
+	float positionTolerance;
+	float rotationTolerance;
+	float scaleTolerance;
+
+	// Drop tracks that collapse to the bind pose, the skeleton's ref pose covers them
+	bool stripBindPoseTracks;
+
+	// Error bounds handed to the linear key reduction codec
+	float maxPosDiff;
+	float maxAngleDiff;
+	float maxScaleDiff;
+};
+
+// 4.24 keeps the codec on each sequence, so every sequence gets its own instance built from the set's settings
+UAnimCompress* MakeAnimCompression(UAnimSequence* AnimSeq, const AnimCompressSettings& settings) {
+	UAnimCompress_RemoveLinearKeys* Codec = NewObject<UAnimCompress_RemoveLinearKeys>(AnimSeq);
+	Codec->MaxPosDiff = settings.maxPosDiff;
+	Codec->MaxAngleDiff = settings.maxAngleDiff;
+	Codec->MaxScaleDiff = settings.maxScaleDiff;
+	Codec->bActuallyFilterLinearKeys = true;
+	return Codec;
+}
+
+template<typename KeyType, typename EqualFunc>
+bool IsConstantChannel(const TArray<KeyType>& frames, EqualFunc equals) {
+	for (int i = 1; i < frames.Num(); ++i) {
+		if (!equals(frames[0], frames[i])) {
+			return false;
+		}
+	}
+	return true;
+}
+
+template<typename KeyType, typename EqualFunc>
+void FillTrackKeys(TArray<KeyType>& keys, const TArray<KeyType>& frames, EqualFunc equals) {
+	if (frames.Num() == 0) {
+		return;
+	}
+
+	if (IsConstantChannel(frames, equals)) {
+		keys.SetNumUninitialized(1);
+		keys[0] = frames[0];
+		return;
+	}
+
+	keys.SetNumUninitialized(frames.Num());
+	for (int i = 0; i < frames.Num(); ++i) {
+		keys[i] = frames[i];
+	}
 }
 
-UAnimSequence* ImportSkeletalAnim(const FString& PackageName, FString& AnimName, ImportSkelData& skelData, const Zmo& anim) {
+UAnimSequence* ImportSkeletalAnim(const FString& PackageName, FString& AnimName, ImportSkelData& skelData, const Zmo& anim, AnimCompressSettings& settings) {
+	FRoseImportPhaseScope Scope(ERoseImportPhase::AnimImport);
+
 	UPackage* Package = GetOrMakePackage(PackageName, AnimName);
 	if (Package == NULL) {
 		return NULL;
 	}
 
-	UAnimSequence* AnimSeq = CastChecked<UAnimSequence>(NewObject<UAnimSequence>());
-		//StaticConstructObject(UAnimSequence::StaticClass(), Package, *AnimName, RF_Standalone | RF_Public));
+	UAnimSequence* AnimSeq = NewObject<UAnimSequence>(Package, *AnimName, RF_Standalone | RF_Public);
 	if (AnimSeq == NULL) {
 		return NULL;
 	}
 
 	// Notify the asset registry
-	FAssetRegistryModule::AssetCreated(AnimSeq);
+	NotifyAssetCreated(AnimSeq);
 
 	// Set the dirty flag so this package will get saved later
 	AnimSeq->MarkPackageDirty();
@@ -649,40 +1259,43 @@ UAnimSequence* ImportSkeletalAnim(const FString& PackageName, FString& AnimName,
 	AnimSeq->SequenceLength = (float)anim.frameCount / (float)anim.framesPerSecond;
 	AnimSeq->SetRawNumberOfFrame(anim.frameCount);
 
+	auto posEquals = [&settings](const FVector& a, const FVector& b) {
+		return a.Equals(b, settings.positionTolerance);
+	};
+	auto rotEquals = [&settings](const FQuat& a, const FQuat& b) {
+		return FMath::Abs(a | b) >= 1.0f - settings.rotationTolerance;
+	};
+	auto scaleEquals = [&settings](const FVector& a, const FVector& b) {
+		return a.Equals(b, settings.scaleTolerance);
+	};
+
 	TArray<FRawAnimSequenceTrack> tracks;
+	tracks.SetNum(skelData.data.bones.Num());
 	for (int i = 0; i < skelData.data.bones.Num(); ++i) {
 		const Zmd::Bone& bone = skelData.data.bones[i];
-		FRawAnimSequenceTrack track;
+		FRawAnimSequenceTrack& track = tracks[i];
 		// All keys must be ABSOLUTE for Unreal!
-		track.PosKeys.Add(bone.translation);
-		track.RotKeys.Add(bone.rotation);
-		track.ScaleKeys.Add(FVector(1, 1, 1));
-		tracks.Add(track);
+		track.PosKeys.Init(bone.translation, 1);
+		track.RotKeys.Init(bone.rotation, 1);
+		track.ScaleKeys.Init(FVector(1, 1, 1), 1);
 	}
 
 	for (int i = 0; i < anim.channels.Num(); ++i) {
 		Zmo::Channel* channel = anim.channels[i];
+		if (channel->index >= (uint32)tracks.Num()) {
+			UE_LOG(LogTemp, Warning, TEXT("%s: channel %d animates bone %u, the skeleton has %d"), *AnimName, i, channel->index, tracks.Num());
+			continue;
+		}
+
 		FRawAnimSequenceTrack& track = tracks[channel->index];
 		if (channel->type() == Zmo::ChannelType::Position) {
-			auto posChannel = (Zmo::PositionChannel*)channel;
-			track.PosKeys.Empty();
-			for (int j = 0; j < posChannel->frames.Num(); ++j) {
-				track.PosKeys.Add(posChannel->frames[j]);
-			}
+			FillTrackKeys(track.PosKeys, ((Zmo::PositionChannel*)channel)->frames, posEquals);
 		}
 		else if (channel->type() == Zmo::ChannelType::Rotation) {
-			auto rotChannel = (Zmo::RotationChannel*)channel;
-			track.RotKeys.Empty();
-			for (int j = 0; j < rotChannel->frames.Num(); ++j) {
-				track.RotKeys.Add(rotChannel->frames[j]);
-			}
+			FillTrackKeys(track.RotKeys, ((Zmo::RotationChannel*)channel)->frames, rotEquals);
 		}
 		else if (channel->type() == Zmo::ChannelType::Scale) {
-			auto scaleChannel = (Zmo::ScaleChannel*)channel;
-			track.ScaleKeys.Empty();
-			for (int j = 0; j < scaleChannel->frames.Num(); ++j) {
-				track.ScaleKeys.Add(scaleChannel->frames[j]);
-			}
+			FillTrackKeys(track.ScaleKeys, ((Zmo::ScaleChannel*)channel)->frames, scaleEquals);
 		}
 		else {
 			UE_DEBUG_BREAK();
@@ -694,7 +1307,17 @@ UAnimSequence* ImportSkeletalAnim(const FString& PackageName, FString& AnimName,
 	//AnimSeq->TrackToSkeletonMapTable.Empty();
 
 	for (int i = 0; i < tracks.Num(); ++i) {
-		AnimSeq->AddNewRawTrack(skelData.data.bones[i].name, &tracks[i]);
+		const Zmd::Bone& bone = skelData.data.bones[i];
+		const FRawAnimSequenceTrack& track = tracks[i];
+
+		if (settings.stripBindPoseTracks &&
+			track.PosKeys.Num() == 1 && posEquals(track.PosKeys[0], bone.translation) &&
+			track.RotKeys.Num() == 1 && rotEquals(track.RotKeys[0], bone.rotation) &&
+			track.ScaleKeys.Num() == 1 && scaleEquals(track.ScaleKeys[0], FVector(1, 1, 1))) {
+			continue;
+		}
+
+		AnimSeq->AddNewRawTrack(FName(*bone.name), &tracks[i]);
 
 		//AnimSeq->BakeOutVirtualBoneTracks(tracks[i], skelData.data.bones[i].name, FTrackToSkeletonMap(i));
 		/* AnimSeq->RawAnimationData.Add(tracks[i]);
@@ -702,6 +1325,8 @@ UAnimSequence* ImportSkeletalAnim(const FString& PackageName, FString& AnimName,
 		AnimSeq->TrackToSkeletonMapTable.Add(FTrackToSkeletonMap(i)); */
 	}
 
+	AnimSeq->CompressionScheme = MakeAnimCompression(AnimSeq, settings);
+
 	AnimSeq->PostProcessSequence();
 
 	AnimSeq->PostEditChange();
@@ -724,78 +1349,252 @@ const TCHAR* animNames[] = {
 };
 const int MaxAnims = 11;
 
-void ImportChar(const Chr& chars, const Zsc& meshs, uint32 charIdx) {
-	FString CharName = FString::Printf(TEXT("Char_%d"), charIdx);
-	FString PackageName = FString(TEXT("/")) + CharName;
+FString NormalizeRosePath(const FString& RosePath) {
+	FString Key = RosePath.ToUpper();
+	FPaths::NormalizeFilename(Key);
+	return Key;
+}
+
+// Parses every distinct path once, spread over the task graph
+template<typename ParsedType>
+void ParseUniqueFiles(const TArray<FString>& Paths, TMap<FString, TSharedPtr<ParsedType>>& Parsed) {
+	TArray<FString> Missing;
+	for (int i = 0; i < Paths.Num(); ++i) {
+		FString Key = NormalizeRosePath(Paths[i]);
+		if (!Parsed.Contains(Key)) {
+			Parsed.Add(Key, nullptr);
+			Missing.Add(Paths[i]);
+		}
+		else {
+			FRoseImportStats::Get().Increment(ERoseImportCounter::CacheHits);
+		}
+	}
 
-	const Chr::Character& mchar = chars.characters[charIdx];
+	TArray<TSharedPtr<ParsedType>> Results;
+	Results.SetNum(Missing.Num());
+	ParallelFor(Missing.Num(), [&](int32 i) {
+		Results[i] = ParseRoseFile<ParsedType>(Missing[i]);
+	});
 
-	ImportMeshData meshData;
-	Zmd meshZmd(*(RoseBasePath + chars.skeletons[mchar.skeletonIdx]));
-	FString SkelPackage;
-	FString SkelName;
-	UE_DEBUG_BREAK();
-	// ToDo Names
-	ImportSkelData skelData(meshZmd, SkelPackage, SkelName);
+	for (int i = 0; i < Missing.Num(); ++i) {
+		Parsed[NormalizeRosePath(Missing[i])] = Results[i];
+	}
+}
 
-	int texIdx = 0;
-	for (int i = 0; i < mchar.models.Num(); ++i) {
-		const Zsc::Model& model = meshs.models[mchar.models[i]];
+// Returns a file parsed ahead of time, parsing it now if nothing scheduled it
+template<typename ParsedType>
+TSharedPtr<ParsedType> GetOrParseFile(TMap<FString, TSharedPtr<ParsedType>>& Parsed, const FString& Path) {
+	FString Key = NormalizeRosePath(Path);
+	TSharedPtr<ParsedType>* Existing = Parsed.Find(Key);
+	if (Existing && Existing->IsValid()) {
+		FRoseImportStats::Get().Increment(ERoseImportCounter::CacheHits);
+		return *Existing;
+	}
 
-		for (int j = 0; j < model.parts.Num(); ++j) {
-			const Zsc::Part& part = model.parts[j];
-			const Zsc::Texture& tex = meshs.textures[part.texIdx];
+	TSharedPtr<ParsedType> Result = ParseRoseFile<ParsedType>(Path);
+	Parsed.Add(Key, Result);
+	return Result;
+}
+
+// Source files parsed for one import, keyed by normalized ROSE path
+struct ImportParseCache {
+	TMap<FString, TSharedPtr<Zms>> zms;
+	TMap<FString, TSharedPtr<Zmo>> zmo;
+	TMap<FString, TSharedPtr<Him>> him;
+	TMap<FString, TSharedPtr<Til>> til;
+	TMap<FString, TSharedPtr<Ifo>> ifo;
+	TMap<FString, TSharedPtr<Lit>> lit;
+};
+
+UAnimSequence* GetOrImportSkeletalAnim(ImportSkelData& skelData, const FString& ZmoPath, const Zmo& anim, AnimCompressSettings& settings) {
+	FString Key = NormalizeRosePath(ZmoPath);
+	UAnimSequence** Existing = skelData.anims.Find(Key);
+	if (Existing) {
+		FRoseImportStats::Get().Increment(ERoseImportCounter::CacheHits);
+		return *Existing;
+	}
+
+	FString AnimPackage, AnimName;
+	BuildAssetPath(AnimPackage, AnimName, ZmoPath, FString(TEXT("_")) + skelData.ZmdName);
+
+	UAnimSequence* AnimSeq = GetExistingAsset<UAnimSequence>(AnimPackage, AnimName);
+	if (AnimSeq == NULL) {
+		AnimSeq = ImportSkeletalAnim(AnimPackage, AnimName, skelData, anim, settings);
+	}
+
+	skelData.anims.Add(Key, AnimSeq);
+	return AnimSeq;
+}
 
-			if (part.dummyIdx != 0xFFFF || part.boneIdx != 0xFFFF) {
+// Whether a part's mesh and texture are in the ZSC, a bad entry only loses that part
+bool IsValidCharPart(const Zsc& meshs, const Zsc::Part& part) {
+	return part.meshIdx < meshs.meshes.Num() && part.texIdx < meshs.textures.Num();
+}
+
+void ImportChars(const Chr& chars, const Zsc& meshs, SkeletonCache& skeletons, AnimCompressSettings& animSettings) {
+	TArray<int32> charIdxs;
+	TArray<FString> zmsPaths;
+	TArray<FString> zmoPaths;
+	for (int32 charIdx = 0; charIdx < chars.characters.Num(); ++charIdx) {
+		const Chr::Character& mchar = chars.characters[charIdx];
+		if (!mchar.enabled || mchar.skeletonIdx >= chars.skeletons.Num()) {
+			continue;
+		}
+
+		charIdxs.Add(charIdx);
+
+		for (int i = 0; i < mchar.models.Num(); ++i) {
+			if (mchar.models[i] >= meshs.models.Num()) {
+				UE_LOG(LogTemp, Warning, TEXT("%s: model %d is past the %d in the ZSC, skipped"), *mchar.name, mchar.models[i], meshs.models.Num());
 				continue;
 			}
 
-			FString TextureName = FString::Printf(TEXT("%s_%d_Texture"), *CharName, texIdx);
-			UTexture* UnrealTexture = ImportTexture(PackageName, TextureName, RoseBasePath + tex.filePath);
+			const Zsc::Model& model = meshs.models[mchar.models[i]];
+			for (int j = 0; j < model.parts.Num(); ++j) {
+				if (!IsValidCharPart(meshs, model.parts[j])) {
+					UE_LOG(LogTemp, Warning, TEXT("%s: part %d of model %d names mesh %d or texture %d past the ZSC, skipped"),
+						*mchar.name, j, mchar.models[i], model.parts[j].meshIdx, model.parts[j].texIdx);
+					continue;
+				}
+				zmsPaths.Add(meshs.meshes[model.parts[j].meshIdx]);
+			}
+		}
+
+		for (int i = 0; i < mchar.animations.Num(); ++i) {
+			const Chr::Animation& anim = mchar.animations[i];
+			if (anim.type < MaxAnims && anim.animationIdx < chars.animations.Num()) {
+				zmoPaths.Add(chars.animations[anim.animationIdx]);
+			}
+		}
+	}
+
+	// Skeletons are few and touch the asset registry, the ZMS and ZMO files are many and are parsed off the game thread
+	for (int i = 0; i < charIdxs.Num(); ++i) {
+		skeletons.Get(chars.skeletons[chars.characters[charIdxs[i]].skeletonIdx]);
+	}
+
+	TMap<FString, TSharedPtr<Zms>> parsedZms;
+	TMap<FString, TSharedPtr<Zmo>> parsedZmo;
+	ParseUniqueFiles(zmsPaths, parsedZms);
+	ParseUniqueFiles(zmoPaths, parsedZmo);
+
+	UE_LOG(LogTemp, Log, TEXT("[IMPORT_CHARS] %d characters, %d unique ZMS, %d unique ZMO"), charIdxs.Num(), parsedZms.Num(), parsedZmo.Num());
 
-			FString MaterialName = FString::Printf(TEXT("%s_%d_Material"), *CharName, texIdx);
-			UMaterialInterface* UnrealMaterial = ImportMaterial(PackageName, MaterialName, tex, UnrealTexture);
+	// Materials are shared by every character using the same ZSC texture entry
+	TMap<uint16, UMaterialInterface*> materials;
+	TArray<ImportMeshData> meshDatas;
+	meshDatas.SetNum(charIdxs.Num());
+	for (int c = 0; c < charIdxs.Num(); ++c) {
+		const Chr::Character& mchar = chars.characters[charIdxs[c]];
+		ImportMeshData& meshData = meshDatas[c];
 
-			meshData.materials.Add(UnrealMaterial);
+		for (int i = 0; i < mchar.models.Num(); ++i) {
+			// Out of range entries were reported while gathering the files
+			if (mchar.models[i] >= meshs.models.Num()) {
+				continue;
+			}
+			const Zsc::Model& model = meshs.models[mchar.models[i]];
 
-			auto meshZms = new Zms(*(RoseBasePath + meshs.meshes[part.meshIdx]));
-			meshData.meshes.Add(ImportMeshData::Item(*meshZms, texIdx));
+			for (int j = 0; j < model.parts.Num(); ++j) {
+				const Zsc::Part& part = model.parts[j];
+				if (!IsValidCharPart(meshs, part) || part.dummyIdx != 0xFFFF || part.boneIdx != 0xFFFF) {
+					continue;
+				}
+				const Zsc::Texture& tex = meshs.textures[part.texIdx];
+
+				UMaterialInterface** Material = materials.Find(part.texIdx);
+				if (!Material) {
+					FString TexturePackage, TextureName;
+					BuildAssetPath(TexturePackage, TextureName, tex.filePath, "_Texture");
+					UTexture* UnrealTexture = ImportTexture(TexturePackage, TextureName, RoseBasePath + tex.filePath);
+
+					FString MaterialPackage, MaterialName;
+					// One file can be listed with different render states, the entry index keeps their materials apart
+					BuildAssetPath(MaterialPackage, MaterialName, tex.filePath, FString::Printf(TEXT("_%d_Material"), part.texIdx));
+					UMaterialInterface* UnrealMaterial = GetExistingAsset<UMaterialInterface>(MaterialPackage, MaterialName);
+					if (UnrealMaterial == NULL) {
+						UnrealMaterial = ImportMaterial(MaterialPackage, MaterialName, tex, UnrealTexture);
+					}
+					Material = &materials.Add(part.texIdx, UnrealMaterial);
+				}
+				else {
+					FRoseImportStats::Get().Increment(ERoseImportCounter::CacheHits);
+				}
 
-			texIdx++;
+				const TSharedPtr<Zms>& meshZms = parsedZms[NormalizeRosePath(meshs.meshes[part.meshIdx])];
+				meshData.meshes.Add(ImportMeshData::Item(meshZms, meshData.materials.Num()));
+				meshData.materials.Add(*Material);
+			}
 		}
 	}
 
-	USkeletalMesh* skelMesh = ImportSkeletalMesh(PackageName, CharName, meshData, skelData);
+	IMeshUtilities& MeshUtilities = FModuleManager::Get().LoadModuleChecked<IMeshUtilities>("MeshUtilities");
+
+	TArray<ImportSkelData*> charSkels;
+	for (int c = 0; c < charIdxs.Num(); ++c) {
+		charSkels.Add(&skeletons.Get(chars.skeletons[chars.characters[charIdxs[c]].skeletonIdx]));
+	}
 
-	for (int i = 0; i < mchar.animations.Num(); ++i) {
-		const Chr::Animation& anim = mchar.animations[i];
+	TArray<PreparedSkeletalMesh> prepared;
+	prepared.SetNum(charIdxs.Num());
+	ParallelFor(charIdxs.Num(), [&](int32 c) {
+		if (meshDatas[c].meshes.Num() > 0) {
+			PrepareSkeletalMesh(MeshUtilities, meshDatas[c], charSkels[c]->data, prepared[c]);
+		}
+	});
 
-		if (anim.type >= MaxAnims) {
-			//UE_LOG(RosePlugin, Warning, TEXT("Skipped unknown animation %d"), anim.type);
-			continue;
+	for (int c = 0; c < charIdxs.Num(); ++c) {
+		int32 charIdx = charIdxs[c];
+		const Chr::Character& mchar = chars.characters[charIdx];
+		ImportSkelData& skelData = *charSkels[c];
+
+		FString CharName = FString::Printf(TEXT("Char_%d"), charIdx);
+		FString PackageName = TEXT("/NPC");
+
+		USkeletalMesh* skelMesh = NULL;
+		if (meshDatas[c].meshes.Num() > 0) {
+			skelMesh = FinishSkeletalMesh(PackageName, CharName, meshDatas[c], skelData, prepared[c]);
 		}
 
-		Zmo animZmo(*(RoseBasePath + chars.animations[anim.animationIdx]));
-		FString AnimName = FString::Printf(TEXT("%s_%s"), *CharName, animNames[anim.type]);
-		UAnimSequence* animSeq = ImportSkeletalAnim(PackageName, AnimName, skelData, animZmo);
+		// Animation sets live on the skeleton, the mesh only records which shared sequence fills each slot
+		for (int i = 0; i < mchar.animations.Num(); ++i) {
+			const Chr::Animation& anim = mchar.animations[i];
+
+			if (anim.type >= MaxAnims || anim.animationIdx >= chars.animations.Num()) {
+				//UE_LOG(RosePlugin, Warning, TEXT("Skipped unknown animation %d"), anim.type);
+				continue;
+			}
+
+			const FString& ZmoPath = chars.animations[anim.animationIdx];
+			const TSharedPtr<Zmo>& animZmo = parsedZmo[NormalizeRosePath(ZmoPath)];
+			UAnimSequence* animSeq = GetOrImportSkeletalAnim(skelData, ZmoPath, *animZmo, animSettings);
+
+			if (skelMesh && animSeq) {
+				skelMesh->GetOutermost()->GetMetaData()->SetValue(skelMesh, animNames[anim.type], *animSeq->GetPathName());
+			}
+		}
 	}
 }
 
 USkeletalMesh* ImportAvatarItem(const FString& ItemTypeName, const Zsc& meshs, ImportSkelData& skelData, int modelIdx, int boneIdx = -1) {
+	if (modelIdx < 0 || modelIdx >= meshs.models.Num() || meshs.models[modelIdx].parts.Num() == 0) {
+		UE_LOG(LogTemp, Warning, TEXT("%s_%d: no such model or it has no parts, skipped"), *ItemTypeName, modelIdx);
+		return NULL;
+	}
+
 	const Zsc::Model& model = meshs.models[modelIdx];
 	ImportMeshData meshData;
 
-	if (model.parts.Num() == 0) {
-		UE_DEBUG_BREAK();
-	}
-
 	for (int j = 0; j < model.parts.Num(); ++j) {
 		const Zsc::Part& part = model.parts[j];
-		const Zsc::Texture& tex = meshs.textures[part.texIdx];
-
+		if (!IsValidCharPart(meshs, part)) {
+			UE_LOG(LogTemp, Warning, TEXT("%s_%d: part %d names mesh %d or texture %d past the ZSC, skipped"), *ItemTypeName, modelIdx, j, part.meshIdx, part.texIdx);
+			continue;
+		}
 		if (part.dummyIdx != 0xFFFF || part.boneIdx != 0xFFFF) {
 			continue;
 		}
+		const Zsc::Texture& tex = meshs.textures[part.texIdx];
 
 		FString ZmsPath = meshs.meshes[part.meshIdx];
 
@@ -807,10 +1606,9 @@ USkeletalMesh* ImportAvatarItem(const FString& ItemTypeName, const Zsc& meshs, I
 		BuildAssetPath(MaterialPackage, MaterialName, ZmsPath);
 		MaterialName = FString::Printf(TEXT("Model_%d_%d_Material"), modelIdx, j);
 		UMaterialInterface* UnrealMaterial = ImportMaterial(MaterialPackage, MaterialName, tex, UnrealTexture);
-		meshData.materials.Add(UnrealMaterial);
 
-		auto meshZms = new Zms(*(RoseBasePath + ZmsPath));
-		meshData.meshes.Add(ImportMeshData::Item(*meshZms, j));
+		meshData.meshes.Add(ImportMeshData::Item(ParseRoseFile<Zms>(ZmsPath), meshData.materials.Num()));
+		meshData.materials.Add(UnrealMaterial);
 	}
 
 	FString ModelPackage, ModelName;
@@ -856,179 +1654,815 @@ CurveType* CreateCurveObject(UObject* PackagePtr, FName& AssetName)
 }
 
 
-UBlueprint* ImportWorldZscModel(const FString& MdlTypeName, const Zsc& meshs, int modelIdx) {
-	const Zsc::Model& model = meshs.models[modelIdx];
+// Small textures packed into shared atlases, one set per render state, so the parts sampling them also share a
+// material. Only parts whose UVs stay inside 0..1 can use a cell, anything tiling keeps its own texture.
+class TextureAtlasSet {
+public:
+	struct Cell {
+		int32 atlasIdx;
+		// Texel position of the cell in its atlas
+		FIntPoint origin;
+		// Scale in XY and bias in ZW that move a part's 0..1 UVs into the cell
+		FVector4 scaleBias;
+	};
 
-	FString BPPackageName = TEXT("/MAPS");
-	FString BPAssetName = FString::Printf(TEXT("%s_%d"), *MdlTypeName, modelIdx);
+	// Padding is a power of two, it decides how many mips the atlases get, see CreateAtlas
+	TextureAtlasSet(int32 _atlasSize = 1024, int32 _maxTextureSize = 128, int32 _padding = 4)
+		: atlasSize(_atlasSize), maxTextureSize(_maxTextureSize), padding(_padding), mipCount(FMath::FloorLog2(_padding) + 1) {}
 
-	UPackage* BPPackage = GetOrMakePackage(BPPackageName, BPAssetName);
-	if (BPPackage == NULL) {
-		return NULL;
+	void AddCandidate(RosePathHandle texture, const Zsc::Texture& texData) {
+		FString key = GetCellKey(texture, texData);
+		if (!candidateKeys.Contains(key)) {
+			candidateKeys.Add(key);
+			candidates.Add(Candidate{ texture, texData, key });
+		}
 	}
 
-	UBlueprint* Blueprint = FKismetEditorUtilities::CreateBlueprint(
-		AActor::StaticClass(), BPPackage, *BPAssetName,
-		BPTYPE_Normal, UBlueprint::StaticClass(),
-		UBlueprintGeneratedClass::StaticClass(),
-		FName("RosePluginWhat"));
+	// Decodes the candidates on the task graph, then packs and creates the atlases on the game thread
+	void Build() {
+		FRoseImportPhaseScope Scope(ERoseImportPhase::TextureAtlas);
 
-	USCS_Node* RootNode = NULL;
-	for (int j = 0; j < model.parts.Num(); ++j) {
-		const Zsc::Part& part = model.parts[j];
-		const Zsc::Texture& tex = meshs.textures[part.texIdx];
-		const FString& mesh = meshs.meshes[part.meshIdx];
+		TArray<FString> pngPaths;
+		for (const Candidate& c : candidates) {
+			pngPaths.Add((RoseBasePath + GetPathTable().GetSourcePath(c.texture)).Replace(TEXT("DDS"), TEXT("png")));
+		}
 
-		FString ModelPackage, ModelName;
-		BuildAssetPath(ModelPackage, ModelName, mesh);
+		IImageWrapperModule& ImageWrapperModule = FModuleManager::LoadModuleChecked<IImageWrapperModule>(FName("ImageWrapper"));
+		TArray<Image> images;
+		images.SetNum(candidates.Num());
+		ParallelFor(candidates.Num(), [&](int32 i) {
+			Image& image = images[i];
+			image.width = 0;
+			image.height = 0;
+
+			TArray<uint8> Data;
+			if (!FFileHelper::LoadFileToArray(Data, *pngPaths[i])) {
+				return;
+			}
 
-		UPackage* Package = GetOrMakePackage(ModelPackage, ModelName);
-		if (Package == NULL) {
-			return NULL;
-		}
+			TSharedPtr<IImageWrapper> Wrapper = ImageWrapperModule.CreateImageWrapper(EImageFormat::PNG);
+			const TArray<uint8>* Raw = NULL;
+			if (!Wrapper.IsValid() || !Wrapper->SetCompressed(Data.GetData(), Data.Num())) {
+				return;
+			}
+			if (Wrapper->GetWidth() > maxTextureSize || Wrapper->GetHeight() > maxTextureSize || !Wrapper->GetRaw(ERGBFormat::BGRA, 8, Raw)) {
+				return;
+			}
 
-		UStaticMesh* StaticMesh = NewObject<UStaticMesh>(Package, *ModelName, RF_Standalone | RF_Public);
+			image.width = Wrapper->GetWidth();
+			image.height = Wrapper->GetHeight();
+			image.pixels = *Raw;
+		});
 
-		if (StaticMesh == NULL) {
-			return NULL;
+		// Only textures drawn with the same render state can end up behind the same material
+		TMap<FString, TArray<int32>> groups;
+		for (int32 i = 0; i < candidates.Num(); ++i) {
+			if (images[i].width > 0) {
+				groups.FindOrAdd(GetSignature(candidates[i].texData)).Add(i);
+			}
 		}
 
-		// Notify the asset registry
-		FAssetRegistryModule::AssetCreated(StaticMesh);
+		for (auto& group : groups) {
+			PackGroup(group.Value, images);
+		}
 
-		// Set the dirty flag so this package will get saved later
-		StaticMesh->MarkPackageDirty();
+		for (int32 a = 0; a < atlases.Num(); ++a) {
+			CreateAtlas(a);
+		}
+
+		UE_LOG(LogTemp, Log, TEXT("Packed %d of %d small textures into %d atlases"), cells.Num(), candidates.Num(), atlases.Num());
+	}
 
-		// make sure it has a new lighting guid
-		StaticMesh->LightingGuid = FGuid::NewGuid();
+	const Cell* Find(RosePathHandle texture, const Zsc::Texture& texData) const {
+		const Cell* cell = cells.Find(GetCellKey(texture, texData));
+		return (cell && atlases[cell->atlasIdx].material) ? cell : NULL;
+	}
 
-		// Set it to use textured lightmaps. Note that Build Lighting will do the error-checking (texcoordindex exists for all LODs, etc).
-		StaticMesh->LightMapResolution = 128;
-		StaticMesh->LightMapCoordinateIndex = 1;
+	// True when the texture has a cell in some atlas, it is then only imported on its own if a tiling part needs it
+	bool Contains(RosePathHandle texture) const {
+		return atlasedTextures.Contains(texture);
+	}
 
-		// new(StaticMesh->GetSourceModels()) FStaticMeshSourceModel();
-		new(StaticMesh->SourceModels) FStaticMeshSourceModel();
+	UMaterialInterface* GetMaterial(int32 atlasIdx) const {
+		return atlases[atlasIdx].material;
+	}
 
-		FStaticMeshSourceModel& SrcModel = StaticMesh->GetSourceModels()[0];
+private:
+	struct Candidate {
+		RosePathHandle texture;
+		Zsc::Texture texData;
+		FString key;
+	};
 
-		FRawMesh RawMesh;
-		SrcModel.RawMeshBulkData->SaveRawMesh(RawMesh);
-		{
-			FString TexturePackage, TextureName;
-			BuildAssetPath(TexturePackage, TextureName, tex.filePath, "_Texture");
-			UTexture* UnrealTexture = ImportTexture(TexturePackage, TextureName, RoseBasePath + tex.filePath);
+	struct Image {
+		int32 width;
+		int32 height;
+		TArray<uint8> pixels;
+	};
 
-			FString MaterialPackage, MaterialName;
-			BuildAssetPath(MaterialPackage, MaterialName, meshs.meshes[part.meshIdx]);
-			MaterialName = FString::Printf(TEXT("Model_%d_%d_Material"), modelIdx, j);
-			UMaterialInterface* UnrealMaterial = ImportMaterial(MaterialPackage, MaterialName, tex, UnrealTexture);
+	struct Atlas {
+		Zsc::Texture texData;
+		TArray<uint8> pixels;
+		UMaterialInterface* material;
+	};
 
-			//StaticMesh->Materials.Add(UnrealMaterial);
-			StaticMesh->StaticMaterials.Add(UnrealMaterial);
+	// Everything in a ZSC texture entry except its file
+	static FString GetSignature(const Zsc::Texture& t) {
+		return FString::Printf(TEXT("%d%d%d%d%d%d_%d_%d_%d_%g_%d_%s"), t.useSkinShader, t.alphaEnabled, t.twoSided,
+			t.alphaTestEnabled, t.depthTestEnabled, t.depthWriteEnabled, t.alphaReference, t.blendType,
+			t.useSpecularShader, t.alpha, t.glowType, *t.glowColor.ToString());
+	}
 
-			Zms meshZms(*(RoseBasePath + mesh));
+	static FString GetCellKey(RosePathHandle texture, const Zsc::Texture& texData) {
+		return FString::Printf(TEXT("%d|%s"), texture, *GetSignature(texData));
+	}
 
-			RawMesh.VertexPositions.AddZeroed(meshZms.vertexPositions.Num());
-			for (int i = 0; i < meshZms.vertexPositions.Num(); ++i) {
-				RawMesh.VertexPositions[i] = meshZms.vertexPositions[i];
+	// Shelf packing, tallest first. Padding repeats the edge texels so filtering does not bleed between cells, and
+	// cells start on multiples of the padding so each of the atlas mips still keeps a texel of it.
+	void PackGroup(TArray<int32>& group, const TArray<Image>& images) {
+		group.Sort([&images](int32 A, int32 B) { return images[A].height > images[B].height; });
+
+		int32 firstAtlas = atlases.Num();
+		int32 atlasIdx = INDEX_NONE;
+		int32 shelfX = 0, shelfY = 0, shelfHeight = 0;
+		TArray<TArray<int32>> atlasCells;
+		for (int32 i : group) {
+			const Image& image = images[i];
+			int32 w = Align(image.width + padding * 2, padding);
+			int32 h = Align(image.height + padding * 2, padding);
+
+			if (atlasIdx != INDEX_NONE && shelfX + w > atlasSize) {
+				shelfX = 0;
+				shelfY += shelfHeight;
+				shelfHeight = 0;
 			}
-
-			RawMesh.WedgeIndices.AddZeroed(meshZms.indexes.Num());
-			//RawMesh.WedgeTangentX.AddZeroed(meshZms.indexes.Num());
-			//RawMesh.WedgeTangentY.AddZeroed(meshZms.indexes.Num());
-			//RawMesh.WedgeTangentZ.AddZeroed(meshZms.indexes.Num());
-			for (int i = 0; i < meshZms.indexes.Num(); ++i) {
-				RawMesh.WedgeIndices[i] = meshZms.indexes[i];
-				//RawMesh.WedgeTangentZ[indexOffset + i] = meshZms.vertexNormals[meshZms.indexes[i]];
+			if (atlasIdx == INDEX_NONE || shelfY + h > atlasSize) {
+				atlasIdx = atlases.Add(Atlas{ candidates[i].texData, TArray<uint8>(), NULL });
+				atlases[atlasIdx].pixels.AddZeroed(atlasSize * atlasSize * 4);
+				atlasCells.AddDefaulted();
+				shelfX = 0;
+				shelfY = 0;
+				shelfHeight = 0;
 			}
 
-			for (int k = 0; k < 4; ++k) {
-				if (meshZms.vertexUvs[k].Num() > 0) {
-					RawMesh.WedgeTexCoords[k].AddZeroed(meshZms.indexes.Num());
-					for (int i = 0; i < meshZms.indexes.Num(); ++i) {
-						RawMesh.WedgeTexCoords[k][i] = meshZms.vertexUvs[k][meshZms.indexes[i]];
-					}
+			Blit(atlases[atlasIdx].pixels, image, shelfX + padding, shelfY + padding);
+			atlasCells.Last().Add(i);
+
+			Cell cell;
+			cell.atlasIdx = atlasIdx;
+			cell.origin = FIntPoint(shelfX + padding, shelfY + padding);
+			cell.scaleBias = FVector4((float)image.width / atlasSize, (float)image.height / atlasSize,
+				(float)(shelfX + padding) / atlasSize, (float)(shelfY + padding) / atlasSize);
+			cells.Add(candidates[i].key, cell);
+
+			shelfX += w;
+			shelfHeight = FMath::Max(shelfHeight, h);
+		}
+
+		// An atlas holding a single texture saves nothing, its texture stays on its own
+		for (int32 a = atlasCells.Num() - 1; a >= 0; --a) {
+			if (atlasCells[a].Num() < 2) {
+				for (int32 i : atlasCells[a]) {
+					cells.Remove(candidates[i].key);
+				}
+				atlases[firstAtlas + a].pixels.Empty();
+			}
+			else {
+				for (int32 i : atlasCells[a]) {
+					atlasedTextures.Add(candidates[i].texture);
 				}
 			}
+		}
+	}
 
-			int faceCount = meshZms.indexes.Num() / 3;
-			RawMesh.FaceMaterialIndices.AddZeroed(faceCount);
-			RawMesh.FaceSmoothingMasks.AddZeroed(faceCount);
-			for (int i = 0; i < faceCount; ++i) {
-				RawMesh.FaceMaterialIndices[i] = 0;
-				RawMesh.FaceSmoothingMasks[i] = 1;
+	void Blit(TArray<uint8>& dst, const Image& image, int32 x, int32 y) const {
+		for (int32 dy = -padding; dy < image.height + padding; ++dy) {
+			int32 sy = FMath::Clamp(dy, 0, image.height - 1);
+			for (int32 dx = -padding; dx < image.width + padding; ++dx) {
+				int32 sx = FMath::Clamp(dx, 0, image.width - 1);
+				FMemory::Memcpy(&dst[((y + dy) * atlasSize + x + dx) * 4], &image.pixels[(sy * image.width + sx) * 4], 4);
 			}
 		}
-		SrcModel.RawMeshBulkData->SaveRawMesh(RawMesh);
+	}
 
-		SrcModel.BuildSettings.bRemoveDegenerates = true;
-		SrcModel.BuildSettings.bRecomputeNormals = false;
-		SrcModel.BuildSettings.bRecomputeTangents = false;
+	void CreateAtlas(int32 atlasIdx) {
+		Atlas& atlas = atlases[atlasIdx];
+		if (atlas.pixels.Num() == 0) {
+			return;
+		}
 
-		StaticMesh->Build(true);
+		FString PackageName = TEXT("/ATLAS");
+		FString TextureName = FString::Printf(TEXT("Atlas_%d_Texture"), atlasIdx);
+		UPackage* Package = GetOrMakePackage(PackageName, TextureName);
+		if (Package == NULL) {
+			return;
+		}
 
-		// Set up the mesh collision
-		StaticMesh->CreateBodySetup();
+		// A full chain would average neighbouring cells together once a mip texel is wider than the padding, so the
+		// atlas only carries the mips its padding covers and leaves them as they are built here
+		TArray<uint8> mips = MoveTemp(atlas.pixels);
+		int32 mipOffset = 0;
+		for (int32 m = 1, mipSize = atlasSize / 2; m < mipCount; ++m, mipSize /= 2) {
+			int32 prevOffset = mipOffset;
+			mipOffset = mips.Num();
+			mips.AddUninitialized(mipSize * mipSize * 4);
+			for (int32 y = 0; y < mipSize; ++y) {
+				for (int32 x = 0; x < mipSize; ++x) {
+					for (int32 c = 0; c < 4; ++c) {
+						const uint8* src = &mips[prevOffset + ((y * 2) * mipSize * 2 + x * 2) * 4 + c];
+						int32 sum = src[0] + src[4] + src[mipSize * 2 * 4] + src[mipSize * 2 * 4 + 4];
+						mips[mipOffset + (y * mipSize + x) * 4 + c] = (uint8)((sum + 2) / 4);
+					}
+				}
+			}
+		}
 
-		// Create new GUID
-		StaticMesh->BodySetup->InvalidatePhysicsData();
+		UTexture2D* Texture = NewObject<UTexture2D>(Package, *TextureName, RF_Standalone | RF_Public);
+		Texture->Source.Init(atlasSize, atlasSize, 1, mipCount, TSF_BGRA8, mips.GetData());
+		Texture->MipGenSettings = TMGS_LeaveExistingMips;
+		Texture->SRGB = true;
+		Texture->PostEditChange();
+		NotifyAssetCreated(Texture);
+		Texture->MarkPackageDirty();
 
-		// Per-poly collision for now
-		StaticMesh->BodySetup->CollisionTraceFlag = ECollisionTraceFlag::CTF_UseComplexAsSimple;
-		StaticMesh->BodySetup->bDoubleSidedGeometry = true;
+		FString MaterialName = FString::Printf(TEXT("Atlas_%d_Material"), atlasIdx);
+		atlas.material = ImportMaterial(PackageName, MaterialName, atlas.texData, Texture);
+	}
 
-		// refresh collision change back to staticmesh components
-		RefreshCollisionChange(StaticMesh);
+	int32 atlasSize;
+	int32 maxTextureSize;
+	int32 padding;
+	int32 mipCount;
+	TArray<Candidate> candidates;
+	TSet<FString> candidateKeys;
+	TArray<Atlas> atlases;
+	TMap<FString, Cell> cells;
+	TSet<RosePathHandle> atlasedTextures;
+};
 
-		for (int32 SectionIndex = 0; SectionIndex < StaticMesh->Materials_DEPRECATED.Num(); SectionIndex++)
-		{
-			FMeshSectionInfo Info = StaticMesh->SectionInfoMap.Get(0, SectionIndex);
-			Info.bEnableCollision = true;
-			StaticMesh->SectionInfoMap.Set(0, SectionIndex, Info);
-		}
+struct ImportModelOptions {
+	ImportModelOptions() : mergeStaticParts(false), convexDecomposition(false), atlases(NULL) {}
 
-		FString MeshCompNameX = FString::Printf(TEXT("Part_%d_Component"), j);
-		UStaticMeshComponent* MeshComp = NewObject< UStaticMeshComponent>();
-		
-		(UStaticMeshComponent*)NewObject<UStaticMeshComponent>(BPPackage, *MeshCompNameX, RF_Transient);
+	// Bake static parts of a model into one mesh
+	bool mergeStaticParts;
+	// Replace per-polygon collision with convex hulls
+	bool convexDecomposition;
+	// Small textures packed before the models are imported, NULL to give every part its own texture
+	const TextureAtlasSet* atlases;
+};
 
-		//MeshComp->StaticMesh = StaticMesh;
+struct StaticMeshPart {
+	StaticMeshPart(const TSharedPtr<Zms>& _data, int32 _matIdx, const FTransform& _transform, uint16 _collisionType, const FVector4& _uvScaleBias = FVector4(1.0f, 1.0f, 0.0f, 0.0f))
+		: data(_data), matIdx(_matIdx), transform(_transform), collisionType(_collisionType), uvScaleBias(_uvScaleBias) {}
 
-		MeshComp->SetStaticMesh(StaticMesh);
+	TSharedPtr<Zms> data;
+	int32 matIdx;
+	FTransform transform;
+	uint16 collisionType;
+	// Applied to the first UV channel, moves the part into its atlas cell
+	FVector4 uvScaleBias;
+};
 
-		FString MeshCompName = FString::Printf(TEXT("Part_%d"), j);
-		//USCS_Node* MeshNode = Blueprint->SimpleConstructionScript->CreateNode(MeshComp, *MeshCompName);
+// Adds the simple primitive the ZSC asks for, returns false when the part needs triangle collision
+bool AddPartCollision(UBodySetup* BodySetup, const StaticMeshPart& part, bool convexDecomposition) {
+	const Zms& meshZms = *part.data;
+	uint16 mode = part.collisionType & Zsc::CollisionType::ModeMask;
 
-		USCS_Node* MeshNode = Blueprint->SimpleConstructionScript->CreateNodeAndRenameComponent(MeshComp);
+	if (mode == Zsc::CollisionType::None || meshZms.vertexPositions.Num() == 0) {
+		return true;
+	}
 
-		if (RootNode) {
-			RootNode->AddChildNode(MeshNode);
+	if (mode == Zsc::CollisionType::BoundingSphere) {
+		FBox Bounds(ForceInit);
+		for (int i = 0; i < meshZms.vertexPositions.Num(); ++i) {
+			Bounds += part.transform.TransformPosition(meshZms.vertexPositions[i]);
 		}
-		else {
-			Blueprint->SimpleConstructionScript->AddNode(MeshNode);
-			RootNode = MeshNode;
+
+		FKSphereElem Sphere;
+		Sphere.Center = Bounds.GetCenter();
+		Sphere.Radius = 0.0f;
+		for (int i = 0; i < meshZms.vertexPositions.Num(); ++i) {
+			float Dist = FVector::Dist(Sphere.Center, part.transform.TransformPosition(meshZms.vertexPositions[i]));
+			Sphere.Radius = FMath::Max(Sphere.Radius, Dist);
+		}
+		BodySetup->AggGeom.SphereElems.Add(Sphere);
+		return true;
+	}
+
+	if (mode == Zsc::CollisionType::AxisAlignedBoundingBox) {
+		FBox Bounds(ForceInit);
+		for (int i = 0; i < meshZms.vertexPositions.Num(); ++i) {
+			Bounds += part.transform.TransformPosition(meshZms.vertexPositions[i]);
 		}
 
-		MeshComp->SetRelativeLocationAndRotation(part.position, FRotator(part.rotation));
-		MeshComp->SetRelativeScale3D(part.scale);
+		FKBoxElem Box(Bounds.GetSize().X, Bounds.GetSize().Y, Bounds.GetSize().Z);
+		Box.Center = Bounds.GetCenter();
+		BodySetup->AggGeom.BoxElems.Add(Box);
+		return true;
+	}
 
-		if (part.animPath.IsEmpty()) {
-			MeshComp->SetMobility(EComponentMobility::Static);
+	if (mode == Zsc::CollisionType::OrientedBoundingBox) {
+		// The box follows the part's own axes, scale is applied before rotation so it stays a box
+		FBox Bounds(ForceInit);
+		for (int i = 0; i < meshZms.vertexPositions.Num(); ++i) {
+			Bounds += meshZms.vertexPositions[i];
 		}
-		else {
-			MeshComp->SetMobility(EComponentMobility::Movable);
+
+		FVector Size = Bounds.GetSize() * part.transform.GetScale3D().GetAbs();
+		FKBoxElem Box(Size.X, Size.Y, Size.Z);
+		Box.Center = part.transform.TransformPosition(Bounds.GetCenter());
+		Box.Rotation = FRotator(part.transform.GetRotation());
+		BodySetup->AggGeom.BoxElems.Add(Box);
+		return true;
+	}
+
+	if (convexDecomposition) {
+		TArray<FVector> Verts;
+		Verts.SetNumUninitialized(meshZms.vertexPositions.Num());
+		for (int i = 0; i < meshZms.vertexPositions.Num(); ++i) {
+			Verts[i] = part.transform.TransformPosition(meshZms.vertexPositions[i]);
+		}
+
+		// DecomposeMeshToHulls replaces all simple collision, so keep what earlier parts produced
+		FKAggregateGeom PrevGeom = BodySetup->AggGeom;
+		DecomposeMeshToHulls(BodySetup, Verts, meshZms.indexes, 4, 16, 100000);
+		BodySetup->AggGeom.SphereElems.Append(PrevGeom.SphereElems);
+		BodySetup->AggGeom.BoxElems.Append(PrevGeom.BoxElems);
+		BodySetup->AggGeom.ConvexElems.Append(PrevGeom.ConvexElems);
+		return true;
+	}
+
+	return false;
+}
+
+// Normals follow the inverse transpose, so non-uniform and mirroring scales keep them perpendicular to the surface
+FVector TransformPartNormal(const FTransform& Transform, const FVector& Normal) {
+	return Transform.TransformVectorNoScale(Normal * FTransform::GetSafeScaleReciprocal(Transform.GetScale3D())).GetSafeNormal();
+}
+
+UStaticMesh* BuildStaticMesh(const FString& PackageName, FString& MeshName, const TArray<StaticMeshPart>& parts, const TArray<UMaterialInterface*>& materials, bool convexDecomposition) {
+	FRoseImportPhaseScope Scope(ERoseImportPhase::MeshBuild);
+
+	UPackage* Package = GetOrMakePackage(PackageName, MeshName);
+	if (Package == NULL) {
+		return NULL;
+	}
+
+	UStaticMesh* StaticMesh = NewObject<UStaticMesh>(Package, *MeshName, RF_Standalone | RF_Public);
+
+	if (StaticMesh == NULL) {
+		return NULL;
+	}
+
+	// Notify the asset registry
+	NotifyAssetCreated(StaticMesh);
+
+	// Set the dirty flag so this package will get saved later
+	StaticMesh->MarkPackageDirty();
+
+	// make sure it has a new lighting guid
+	StaticMesh->LightingGuid = FGuid::NewGuid();
+
+	// Set it to use textured lightmaps. Note that Build Lighting will do the error-checking (texcoordindex exists for all LODs, etc).
+	StaticMesh->LightMapResolution = 128;
+	StaticMesh->LightMapCoordinateIndex = 1;
+
+	// new(StaticMesh->GetSourceModels()) FStaticMeshSourceModel();
+	new(StaticMesh->SourceModels) FStaticMeshSourceModel();
+
+	FStaticMeshSourceModel& SrcModel = StaticMesh->GetSourceModels()[0];
+
+	for (int i = 0; i < materials.Num(); ++i) {
+		//StaticMesh->Materials.Add(UnrealMaterial);
+		StaticMesh->StaticMaterials.Add(materials[i]);
+	}
+
+	int32 totalVertCount = 0;
+	int32 totalIndexCount = 0;
+	bool hasUvs[4] = { false, false, false, false };
+	// Normals and tangents are per mesh in the build settings, one part without them means recomputing for all
+	bool hasNormals = true;
+	bool hasTangents = true;
+	for (int p = 0; p < parts.Num(); ++p) {
+		totalVertCount += parts[p].data->vertexPositions.Num();
+		totalIndexCount += parts[p].data->indexes.Num();
+		for (int k = 0; k < 4; ++k) {
+			hasUvs[k] |= parts[p].data->vertexUvs[k].Num() > 0;
 		}
+		hasNormals &= parts[p].data->vertexNormals.Num() > 0;
+		hasTangents &= parts[p].data->vertexTangents.Num() > 0;
+	}
+	hasTangents &= hasNormals;
+	FRoseImportStats::Get().Increment(ERoseImportCounter::Triangles, totalIndexCount / 3);
 
-		if (part.collisionType & Zsc::CollisionType::ModeMask) {
-			MeshComp->SetCollisionResponseToAllChannels(ECR_Block);
-			if (part.collisionType & Zsc::CollisionType::NoCameraCollide) {
-				MeshComp->SetCollisionResponseToChannel(ECC_Camera, ECR_Ignore);
+	FRawMesh RawMesh;
+	SrcModel.RawMeshBulkData->SaveRawMesh(RawMesh);
+	{
+		RawMesh.VertexPositions.AddZeroed(totalVertCount);
+		RawMesh.WedgeIndices.AddZeroed(totalIndexCount);
+		if (hasTangents) {
+			RawMesh.WedgeTangentX.AddZeroed(totalIndexCount);
+			RawMesh.WedgeTangentY.AddZeroed(totalIndexCount);
+		}
+		if (hasNormals) {
+			RawMesh.WedgeTangentZ.AddZeroed(totalIndexCount);
+		}
+		for (int k = 0; k < 4; ++k) {
+			if (hasUvs[k]) {
+				RawMesh.WedgeTexCoords[k].AddZeroed(totalIndexCount);
 			}
 		}
+		RawMesh.FaceMaterialIndices.AddZeroed(totalIndexCount / 3);
+		RawMesh.FaceSmoothingMasks.AddZeroed(totalIndexCount / 3);
+
+		int32 vertOffset = 0;
+		int32 indexOffset = 0;
+		for (int p = 0; p < parts.Num(); ++p) {
+			const Zms& meshZms = *parts[p].data;
+			const FTransform& transform = parts[p].transform;
+			const FVector4& uvScaleBias = parts[p].uvScaleBias;
+
+			for (int i = 0; i < meshZms.vertexPositions.Num(); ++i) {
+				RawMesh.VertexPositions[vertOffset + i] = transform.TransformPosition(meshZms.vertexPositions[i]);
+			}
+
+			// Mirroring scales flip the winding, swap two corners to keep the faces pointing out
+			const bool flipWinding = transform.GetDeterminant() < 0.0f;
+			for (int i = 0; i < meshZms.indexes.Num(); ++i) {
+				int32 srcIdx = i;
+				if (flipWinding && (i % 3) != 0) {
+					srcIdx = (i % 3 == 1) ? i + 1 : i - 1;
+				}
+
+				RawMesh.WedgeIndices[indexOffset + i] = vertOffset + meshZms.indexes[srcIdx];
+				for (int k = 0; k < 4; ++k) {
+					if (meshZms.vertexUvs[k].Num() > 0) {
+						FVector2D uv = meshZms.vertexUvs[k][meshZms.indexes[srcIdx]];
+						if (k == 0) {
+							uv = FVector2D(uv.X * uvScaleBias.X + uvScaleBias.Z, uv.Y * uvScaleBias.Y + uvScaleBias.W);
+						}
+						RawMesh.WedgeTexCoords[k][indexOffset + i] = uv;
+					}
+				}
+			}
+
+			int faceOffset = indexOffset / 3;
+			int faceCount = meshZms.indexes.Num() / 3;
+			for (int i = 0; i < faceCount; ++i) {
+				RawMesh.FaceMaterialIndices[faceOffset + i] = parts[p].matIdx;
+				RawMesh.FaceSmoothingMasks[faceOffset + i] = 1;
+			}
+
+			for (int i = 0; hasNormals && i < faceCount; ++i) {
+				int32 wedgeIdx = indexOffset + i * 3;
+				FVector Positions[3];
+				FVector2D Uvs[3];
+				for (int k = 0; k < 3; ++k) {
+					Positions[k] = RawMesh.VertexPositions[RawMesh.WedgeIndices[wedgeIdx + k]];
+					Uvs[k] = hasUvs[0] ? RawMesh.WedgeTexCoords[0][wedgeIdx + k] : FVector2D::ZeroVector;
+				}
+				FVector FaceBitangent = GetFaceUvBitangent(Positions, Uvs);
+
+				for (int k = 0; k < 3; ++k) {
+					uint32 vertIdx = RawMesh.WedgeIndices[wedgeIdx + k] - vertOffset;
+					FVector Normal = TransformPartNormal(transform, meshZms.vertexNormals[vertIdx]);
+					RawMesh.WedgeTangentZ[wedgeIdx + k] = Normal;
+					if (hasTangents) {
+						FVector Tangent = transform.TransformVector(meshZms.vertexTangents[vertIdx]).GetSafeNormal();
+						RawMesh.WedgeTangentX[wedgeIdx + k] = Tangent;
+						RawMesh.WedgeTangentY[wedgeIdx + k] = GetWedgeBitangent(Normal, Tangent, FaceBitangent);
+					}
+				}
+			}
+
+			vertOffset += meshZms.vertexPositions.Num();
+			indexOffset += meshZms.indexes.Num();
+		}
+	}
+	SrcModel.RawMeshBulkData->SaveRawMesh(RawMesh);
+
+	SrcModel.BuildSettings.bRemoveDegenerates = true;
+	SrcModel.BuildSettings.bRecomputeNormals = !hasNormals;
+	SrcModel.BuildSettings.bRecomputeTangents = !hasTangents;
+	// The baked ROSE lightmaps are laid out on the ZMS second UV set, generated lightmap UVs would overwrite it
+	SrcModel.BuildSettings.bGenerateLightmapUVs = !hasUvs[1];
+
+	StaticMesh->Build(true);
+
+	// Set up the mesh collision
+	StaticMesh->CreateBodySetup();
+
+	// Create new GUID
+	StaticMesh->BodySetup->InvalidatePhysicsData();
+	StaticMesh->BodySetup->RemoveSimpleCollision();
+
+	// Simple primitives where the ZSC asks for them, triangles are only kept for polygon collision parts
+	TArray<bool> sectionCollision;
+	sectionCollision.Init(false, StaticMesh->StaticMaterials.Num());
+	bool needsComplex = false;
+	for (int p = 0; p < parts.Num(); ++p) {
+		if (!AddPartCollision(StaticMesh->BodySetup, parts[p], convexDecomposition)) {
+			sectionCollision[parts[p].matIdx] = true;
+			needsComplex = true;
+		}
+	}
+
+	if (needsComplex) {
+		// Complex queries see the triangles of every colliding part, simple ones keep the primitives where there are any
+		for (int p = 0; p < parts.Num(); ++p) {
+			if (parts[p].collisionType & Zsc::CollisionType::ModeMask) {
+				sectionCollision[parts[p].matIdx] = true;
+			}
+		}
+		const bool hasSimple = StaticMesh->BodySetup->AggGeom.GetElementCount() > 0;
+		StaticMesh->BodySetup->CollisionTraceFlag = hasSimple ? ECollisionTraceFlag::CTF_UseDefault : ECollisionTraceFlag::CTF_UseComplexAsSimple;
+		StaticMesh->BodySetup->bDoubleSidedGeometry = true;
+	}
+	else {
+		StaticMesh->BodySetup->CollisionTraceFlag = ECollisionTraceFlag::CTF_UseSimpleAsComplex;
+		StaticMesh->BodySetup->bDoubleSidedGeometry = false;
+	}
+
+	for (int32 SectionIndex = 0; SectionIndex < StaticMesh->StaticMaterials.Num(); SectionIndex++)
+	{
+		FMeshSectionInfo Info = StaticMesh->SectionInfoMap.Get(0, SectionIndex);
+		Info.bEnableCollision = sectionCollision[SectionIndex];
+		StaticMesh->SectionInfoMap.Set(0, SectionIndex, Info);
+	}
+
+	StaticMesh->BodySetup->CreatePhysicsMeshes();
+
+	// refresh collision change back to staticmesh components
+	RefreshCollisionChange(StaticMesh);
+
+	return StaticMesh;
+}
+
+UTexture* ImportRoseTexture(RosePathHandle TexturePath) {
+	const RosePathTable& Table = GetPathTable();
+	FString TexturePackage, TextureName;
+	Table.GetAssetPath(TexturePath, TexturePackage, TextureName, TEXT("_Texture"));
+	return ImportTexture(TexturePackage, TextureName, RoseBasePath + Table.GetSourcePath(TexturePath));
+}
+
+UTexture* ImportRoseTexture(const FString& RosePath) {
+	return ImportRoseTexture(GetPathTable().Intern(RosePath));
+}
+
+UMaterialInterface* ImportPartMaterial(const Zsc& meshs, const ZscPaths& paths, int modelIdx, int partIdx) {
+	const Zsc::Part& part = meshs.models[modelIdx].parts[partIdx];
+	const Zsc::Texture& tex = meshs.textures[part.texIdx];
+
+	UTexture* UnrealTexture = ImportRoseTexture(paths.textures[part.texIdx]);
+
+	FString MaterialPackage = GetPathTable().GetPackageName(paths.meshes[part.meshIdx]);
+	FString MaterialName = FString::Printf(TEXT("Model_%d_%d_Material"), modelIdx, partIdx);
+	return ImportMaterial(MaterialPackage, MaterialName, tex, UnrealTexture);
+}
+
+// The atlas cell a part samples instead of its own texture, NULL when it has none or its UVs tile. Lightmapped parts
+// never use one, their placed material is built from the part's own texture.
+const TextureAtlasSet::Cell* FindPartAtlasCell(const ImportModelOptions& options, const Zsc& meshs, const ZscPaths& paths, const Zsc::Part& part, const Zms& meshZms) {
+	if (options.atlases == NULL || part.useLightmap || meshZms.vertexUvs[0].Num() == 0) {
+		return NULL;
+	}
+
+	const TextureAtlasSet::Cell* cell = options.atlases->Find(paths.textures[part.texIdx], meshs.textures[part.texIdx]);
+	if (cell == NULL) {
+		return NULL;
+	}
+
+	const float Tolerance = 0.001f;
+	for (const FVector2D& uv : meshZms.vertexUvs[0]) {
+		if (uv.X < -Tolerance || uv.Y < -Tolerance || uv.X > 1.0f + Tolerance || uv.Y > 1.0f + Tolerance) {
+			return NULL;
+		}
+	}
+	return cell;
+}
+
+// Tags a mesh component with the ZSC parts it draws, the tag index is the material slot of the part
+FName GetPartTag(int32 partIdx) {
+	return FName(*FString::Printf(TEXT("Part_%d"), partIdx));
+}
+
+// ZSC parents are 1-based, parts without one hang off the first part like the SCS hierarchy does
+int32 GetPartParent(const Zsc::Model& model, int32 partIdx) {
+	if (partIdx == 0) {
+		return INDEX_NONE;
+	}
+
+	uint16 parentIdx = model.parts[partIdx].parentIdx;
+	if (parentIdx >= 1 && parentIdx <= partIdx) {
+		return parentIdx - 1;
+	}
+	return 0;
+}
+
+FTransform GetPartModelTransform(const Zsc::Model& model, int32 partIdx) {
+	const Zsc::Part& part = model.parts[partIdx];
+	FTransform transform(part.rotation, part.position, part.scale);
+
+	int32 parent = GetPartParent(model, partIdx);
+	if (parent != INDEX_NONE) {
+		transform = transform * GetPartModelTransform(model, parent);
+	}
+	return transform;
+}
+
+// Static parts can be baked together, anything animated or attached to a bone must stay a component
+bool IsMergeablePart(const Zsc::Model& model, int32 partIdx) {
+	const Zsc::Part& part = model.parts[partIdx];
+	if (!part.animPath.IsEmpty() || part.boneIdx != 0xFFFF || part.dummyIdx != 0xFFFF) {
+		return false;
+	}
+
+	int32 parent = GetPartParent(model, partIdx);
+	return parent == INDEX_NONE || IsMergeablePart(model, parent);
+}
+
+USCS_Node* AddMeshComponentNode(UBlueprint* Blueprint, USCS_Node*& RootNode, UStaticMesh* StaticMesh, const FTransform& Transform, bool isStatic, uint16 collisionType) {
+	UStaticMeshComponent* MeshComp = NewObject<UStaticMeshComponent>();
+
+	//MeshComp->StaticMesh = StaticMesh;
+
+	MeshComp->SetStaticMesh(StaticMesh);
+
+	//USCS_Node* MeshNode = Blueprint->SimpleConstructionScript->CreateNode(MeshComp, *MeshCompName);
+
+	USCS_Node* MeshNode = Blueprint->SimpleConstructionScript->CreateNodeAndRenameComponent(MeshComp);
+
+	if (RootNode) {
+		RootNode->AddChildNode(MeshNode);
+	}
+	else {
+		Blueprint->SimpleConstructionScript->AddNode(MeshNode);
+		RootNode = MeshNode;
+	}
+
+	MeshComp->SetRelativeLocationAndRotation(Transform.GetLocation(), FRotator(Transform.GetRotation()));
+	MeshComp->SetRelativeScale3D(Transform.GetScale3D());
+
+	if (isStatic) {
+		MeshComp->SetMobility(EComponentMobility::Static);
+	}
+	else {
+		MeshComp->SetMobility(EComponentMobility::Movable);
+	}
+
+	if (collisionType & Zsc::CollisionType::ModeMask) {
+		MeshComp->SetCollisionResponseToAllChannels(ECR_Block);
+		if (collisionType & Zsc::CollisionType::NoCameraCollide) {
+			MeshComp->SetCollisionResponseToChannel(ECC_Camera, ECR_Ignore);
+		}
+		if (collisionType & Zsc::CollisionType::NotPickable) {
+			MeshComp->SetCollisionResponseToChannel(ECC_Visibility, ECR_Ignore);
+		}
+		if (collisionType & Zsc::CollisionType::HeightOnly) {
+			// Only used to find the ground height, traces still hit it but it has no physics body
+			MeshComp->SetCollisionEnabled(ECollisionEnabled::QueryOnly);
+		}
+		if (collisionType & Zsc::CollisionType::NotMoveable) {
+			// Characters are stopped by it rather than stepping up onto it
+			MeshComp->CanCharacterStepUpOn = ECB_No;
+		}
+	}
+	else {
+		MeshComp->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+		MeshComp->SetCollisionResponseToAllChannels(ECR_Ignore);
+	}
+
+	return MeshNode;
+}
+
+UBlueprint* ImportWorldZscModel(const FString& MdlTypeName, const Zsc& meshs, const ZscPaths& paths, int modelIdx, const ImportModelOptions& options, ImportParseCache& parsed) {
+	FRoseImportPhaseScope Scope(ERoseImportPhase::BlueprintBuild);
+
+	const Zsc::Model& model = meshs.models[modelIdx];
+
+	FString BPPackageName = TEXT("/MAPS");
+	FString BPAssetName = FString::Printf(TEXT("%s_%d"), *MdlTypeName, modelIdx);
+
+	UPackage* BPPackage = GetOrMakePackage(BPPackageName, BPAssetName);
+	if (BPPackage == NULL) {
+		return NULL;
+	}
+
+	UBlueprint* Blueprint = FKismetEditorUtilities::CreateBlueprint(
+		AActor::StaticClass(), BPPackage, *BPAssetName,
+		BPTYPE_Normal, UBlueprint::StaticClass(),
+		UBlueprintGeneratedClass::StaticClass(),
+		FName("RosePluginWhat"));
+	if (Blueprint == NULL) {
+		return NULL;
+	}
+	NotifyAssetCreated(Blueprint);
+
+	TArray<bool> merged;
+	merged.Init(false, model.parts.Num());
+	int32 mergedCount = 0;
+	if (options.mergeStaticParts) {
+		// The merged mesh is a single component, so only parts sharing the same collision flags go into it. Polygon
+		// parts are kept apart from primitive ones too, their triangles would otherwise collide for the whole mesh
+		int32 mergedKey = -1;
+		for (int j = 0; j < model.parts.Num(); ++j) {
+			if (!IsMergeablePart(model, j)) {
+				continue;
+			}
+
+			const uint16 partCollision = model.parts[j].collisionType;
+			const bool polygon = (partCollision & Zsc::CollisionType::ModeMask) == Zsc::CollisionType::Polygon;
+			int32 key = (partCollision & ~Zsc::CollisionType::ModeMask) | (polygon ? Zsc::CollisionType::Polygon : 0);
+			if (mergedKey == -1) {
+				mergedKey = key;
+			}
+			merged[j] = (key == mergedKey);
+			mergedCount += merged[j] ? 1 : 0;
+		}
+	}
+	if (mergedCount < 2) {
+		merged.Init(false, model.parts.Num());
+		mergedCount = 0;
+	}
+
+	USCS_Node* RootNode = NULL;
+	if (mergedCount > 0) {
+		// Bake every static part into one mesh with a section per part, it becomes the root at the model origin
+		TArray<StaticMeshPart> meshParts;
+		TArray<UMaterialInterface*> materials;
+		TArray<FName> partTags;
+		uint16 collisionType = 0;
+		for (int j = 0; j < model.parts.Num(); ++j) {
+			if (!merged[j]) {
+				continue;
+			}
+
+			const Zsc::Part& part = model.parts[j];
+			TSharedPtr<Zms> meshZms = GetOrParseFile(parsed.zms, meshs.meshes[part.meshIdx]);
+			const TextureAtlasSet::Cell* cell = FindPartAtlasCell(options, meshs, paths, part, *meshZms);
+			if (cell) {
+				// Atlased parts keep a slot each so the part tags still line up, they just share the material
+				meshParts.Add(StaticMeshPart(meshZms, materials.Num(), GetPartModelTransform(model, j), part.collisionType, cell->scaleBias));
+				materials.Add(options.atlases->GetMaterial(cell->atlasIdx));
+			}
+			else {
+				meshParts.Add(StaticMeshPart(meshZms, materials.Num(), GetPartModelTransform(model, j), part.collisionType));
+				materials.Add(ImportPartMaterial(meshs, paths, modelIdx, j));
+			}
+			partTags.Add(GetPartTag(j));
+			collisionType |= part.collisionType;
+		}
+
+		FString MergedPackage = BPPackageName;
+		FString MergedName = BPAssetName + TEXT("_Merged");
+		UStaticMesh* MergedMesh = BuildStaticMesh(MergedPackage, MergedName, meshParts, materials, options.convexDecomposition);
+		if (MergedMesh == NULL) {
+			return NULL;
+		}
+
+		USCS_Node* MergedNode = AddMeshComponentNode(Blueprint, RootNode, MergedMesh, FTransform::Identity, true, collisionType);
+		MergedNode->ComponentTemplate->ComponentTags = partTags;
+	}
+
+	for (int j = 0; j < model.parts.Num(); ++j) {
+		if (merged[j]) {
+			continue;
+		}
+
+		const Zsc::Part& part = model.parts[j];
+		const FString& mesh = meshs.meshes[part.meshIdx];
+
+		FString ModelPackage, ModelName;
+		GetPathTable().GetAssetPath(paths.meshes[part.meshIdx], ModelPackage, ModelName);
+
+		TSharedPtr<Zms> meshZms = GetOrParseFile(parsed.zms, mesh);
+		const TextureAtlasSet::Cell* cell = FindPartAtlasCell(options, meshs, paths, part, *meshZms);
+		TArray<StaticMeshPart> meshParts;
+		TArray<UMaterialInterface*> materials;
+		if (cell) {
+			// The UVs now depend on the cell, so the mesh is no longer the plain ZMS asset and is named after both
+			ModelName += FString::Printf(TEXT("_Atlas_%d_%d_%d"), cell->atlasIdx, cell->origin.X, cell->origin.Y);
+			meshParts.Add(StaticMeshPart(meshZms, 0, FTransform::Identity, part.collisionType, cell->scaleBias));
+			materials.Add(options.atlases->GetMaterial(cell->atlasIdx));
+		}
 		else {
-			MeshComp->SetCollisionResponseToAllChannels(ECR_Ignore);
+			meshParts.Add(StaticMeshPart(meshZms, 0, FTransform::Identity, part.collisionType));
+			materials.Add(ImportPartMaterial(meshs, paths, modelIdx, j));
 		}
 
+		UStaticMesh* StaticMesh = BuildStaticMesh(ModelPackage, ModelName, meshParts, materials, options.convexDecomposition);
+		if (StaticMesh == NULL) {
+			return NULL;
+		}
+
+		// Next to a merged root the part needs its full model space placement, otherwise it is relative to the first part
+		FTransform PartTransform = (mergedCount > 0)
+			? GetPartModelTransform(model, j)
+			: FTransform(part.rotation, part.position, part.scale);
+
+		USCS_Node* MeshNode = AddMeshComponentNode(Blueprint, RootNode, StaticMesh, PartTransform, part.animPath.IsEmpty(), part.collisionType);
+		MeshNode->ComponentTemplate->ComponentTags.Add(GetPartTag(j));
+
 		// Import any animations
 		if (!part.animPath.IsEmpty())
 		{
@@ -1042,12 +2476,12 @@ UBlueprint* ImportWorldZscModel(const FString& MdlTypeName, const Zsc& meshs, in
 			UK2Node* TLNodeX = Cast<UK2Node>(TLNode);
 			TLNode->TimelineName = *FString::Printf(TEXT("Part_%d_Anim"), j);
 
-			Zmo anim(*(RoseBasePath + part.animPath));
+			TSharedPtr<Zmo> anim = GetOrParseFile(parsed.zmo, part.animPath);
 
 			UTimelineTemplate* TLTmpl = FBlueprintEditorUtils::AddNewTimeline(Blueprint, TLNode->TimelineName);
 			TLTmpl->bLoop = true;
 			TLTmpl->bAutoPlay = true;
-			TLTmpl->TimelineLength = (float)anim.frameCount / (float)anim.framesPerSecond;
+			TLTmpl->TimelineLength = (float)anim->frameCount / (float)anim->framesPerSecond;
 
 			FName RCurveName = *FString::Printf(TEXT("Curve_%d_Rot"), j);
 			FName PCurveName = *FString::Printf(TEXT("Curve_%d_Pos"), j);
@@ -1059,8 +2493,8 @@ UBlueprint* ImportWorldZscModel(const FString& MdlTypeName, const Zsc& meshs, in
 			bool UsesPosition = false;
 			bool UsesScale = false;
 
-			for (int i = 0; i < anim.channels.Num(); ++i) {
-				Zmo::Channel* channel = anim.channels[i];
+			for (int i = 0; i < anim->channels.Num(); ++i) {
+				Zmo::Channel* channel = anim->channels[i];
 				if (channel->index != 0) {
 					UE_DEBUG_BREAK();
 				}
@@ -1071,13 +2505,13 @@ UBlueprint* ImportWorldZscModel(const FString& MdlTypeName, const Zsc& meshs, in
 					for (int k = 0; k < posChannel->frames.Num(); ++k) {
 						const FVector& frame = posChannel->frames[k];
 						if (k == 0 || frame.X != posChannel->frames[k - 1].X) {
-							PCurve->FloatCurves[0].AddKey((float)k / (float)anim.framesPerSecond, frame.X);
+							PCurve->FloatCurves[0].AddKey((float)k / (float)anim->framesPerSecond, frame.X);
 						}
 						if (k == 0 || frame.Y != posChannel->frames[k - 1].Y) {
-							PCurve->FloatCurves[1].AddKey((float)k / (float)anim.framesPerSecond, frame.Y);
+							PCurve->FloatCurves[1].AddKey((float)k / (float)anim->framesPerSecond, frame.Y);
 						}
 						if (k == 0 || frame.Z != posChannel->frames[k - 1].Z) {
-							PCurve->FloatCurves[2].AddKey((float)k / (float)anim.framesPerSecond, frame.Z);
+							PCurve->FloatCurves[2].AddKey((float)k / (float)anim->framesPerSecond, frame.Z);
 						}
 					}
 				}
@@ -1088,13 +2522,13 @@ UBlueprint* ImportWorldZscModel(const FString& MdlTypeName, const Zsc& meshs, in
 					for (int k = 0; k < rotChannel->frames.Num(); ++k) {
 						FRotator frame = rotChannel->frames[k].Rotator();
 						//if (j == 0 || frame.Pitch != prevFrame.Pitch) {
-						RCurve->FloatCurves[0].AddKey((float)k / (float)anim.framesPerSecond, frame.Pitch, true);
+						RCurve->FloatCurves[0].AddKey((float)k / (float)anim->framesPerSecond, frame.Pitch, true);
 						//}
 						//if (j == 0 || frame.Yaw != prevFrame.Yaw) {
-						RCurve->FloatCurves[1].AddKey((float)k / (float)anim.framesPerSecond, frame.Yaw, true);
+						RCurve->FloatCurves[1].AddKey((float)k / (float)anim->framesPerSecond, frame.Yaw, true);
 						//}
 						//if (j == 0 || frame.Roll != prevFrame.Roll) {
-						RCurve->FloatCurves[2].AddKey((float)k / (float)anim.framesPerSecond, frame.Roll, true);
+						RCurve->FloatCurves[2].AddKey((float)k / (float)anim->framesPerSecond, frame.Roll, true);
 						//}
 						prevFrame = frame;
 					}
@@ -1105,13 +2539,13 @@ UBlueprint* ImportWorldZscModel(const FString& MdlTypeName, const Zsc& meshs, in
 					for (int k = 0; k < scaleChannel->frames.Num(); ++k) {
 						const FVector& frame = scaleChannel->frames[k];
 						if (k == 0 || frame.X != scaleChannel->frames[k - 1].X) {
-							SCurve->FloatCurves[0].AddKey((float)k / (float)anim.framesPerSecond, frame.X);
+							SCurve->FloatCurves[0].AddKey((float)k / (float)anim->framesPerSecond, frame.X);
 						}
 						if (k == 0 || frame.Y != scaleChannel->frames[k - 1].Y) {
-							SCurve->FloatCurves[1].AddKey((float)k / (float)anim.framesPerSecond, frame.Y);
+							SCurve->FloatCurves[1].AddKey((float)k / (float)anim->framesPerSecond, frame.Y);
 						}
 						if (k == 0 || frame.Z != scaleChannel->frames[k - 1].Z) {
-							SCurve->FloatCurves[2].AddKey((float)k / (float)anim.framesPerSecond, frame.Z);
+							SCurve->FloatCurves[2].AddKey((float)k / (float)anim->framesPerSecond, frame.Z);
 						}
 					}
 				}
@@ -1183,244 +2617,199 @@ UBlueprint* ImportWorldZscModel(const FString& MdlTypeName, const Zsc& meshs, in
 	return Blueprint;
 }
 
-AActor* SpawnWorldModel(const FString& NewName, const FString& PackageName, const FString& AssetName, const FQuat& Rot, const FVector& Pos, const FVector& Scale) {
-	FActorSpawnParameters SpawnInfo;
-	SpawnInfo.Name = *NewName;
-
-	auto Model = GetExistingAsset<UBlueprint>(PackageName, AssetName);
-	if (Model != NULL) {
-		AActor* ModelAct = GWorld->SpawnActor<AActor>(Model->GeneratedClass, Pos, FRotator(Rot), SpawnInfo);
-		ModelAct->SetActorScale3D(Scale);
-		return ModelAct;
-	}
-
-	return NULL;
-}
+// Queues world model placements and spawns them a batch at a time. Every actor in a batch is spawned with its
+// construction deferred, then all of them are finished in one pass with navigation locked and no undo recording.
+class WorldPlacementBatch {
+public:
+	// Material for one ZSC part of the placed model, replacing the one the blueprint was built with
+	typedef TPair<int32, UMaterialInterface*> PartMaterial;
 
-void CreateBrushForVolumeActor(AVolume* NewActor, UBrushBuilder* BrushBuilder)
-{
-	if (NewActor != NULL)
-	{
-		// this code builds a brush for the new actor
-		NewActor->PreEditChange(NULL);
+	WorldPlacementBatch(UWorld* _world, int32 _batchSize = 512) : world(_world), batchSize(_batchSize), clusterCellSize(0.0f) {}
 
-		NewActor->PolyFlags = 0;
-		NewActor->Brush = NewObject<UModel>(NewActor, NAME_None, RF_Transactional);
-		NewActor->Brush->Initialize(NULL, true);
-		NewActor->Brush->Polys = NewObject<UPolys>(NewActor->Brush, NAME_None, RF_Transactional);
-		//NewActor->BrushComponent->Brush = NewActor->Brush;
-		NewActor->GetBrushComponent()->Brush = NewActor->Brush;
+	~WorldPlacementBatch() {
+		Flush();
+	}
 
-		if (BrushBuilder != nullptr)
-		{
-			NewActor->BrushBuilder = DuplicateObject<UBrushBuilder>(BrushBuilder, NewActor);
+	void Add(const FString& NewName, UBlueprint* Model, const FQuat& Rot, const FVector& Pos, const FVector& Scale, const TArray<PartMaterial>& PartMaterials = TArray<PartMaterial>()) {
+		if (Model == NULL || Model->GeneratedClass == NULL) {
+			return;
 		}
 
-		BrushBuilder->Build(NewActor->GetWorld(), NewActor);
+		Placement& placement = pending.AddDefaulted_GetRef();
+		placement.name = FName(*NewName);
+		placement.actorClass = Model->GeneratedClass;
+		placement.transform = FTransform(Rot, Pos, Scale);
+		placement.partMaterials = PartMaterials;
+		if (clusterCellSize > 0.0f) {
+			placement.cluster = FIntPoint(FMath::FloorToInt((Pos.X - clusterOrigin.X) / clusterCellSize), FMath::FloorToInt((Pos.Y - clusterOrigin.Y) / clusterCellSize));
+		}
 
-		FBSPOps::csgPrepMovingBrush(NewActor);
+		if (pending.Num() >= batchSize) {
+			Flush();
+		}
+	}
 
-		// Set the texture on all polys to NULL.  This stops invisible textures
-		// dependencies from being formed on volumes.
-		if (NewActor->Brush)
-		{
-			for (int32 poly = 0; poly < NewActor->Brush->Polys->Element.Num(); ++poly)
-			{
-				FPoly* Poly = &(NewActor->Brush->Polys->Element[poly]);
-				Poly->Material = NULL;
-			}
+	int32 Flush() {
+		if (pending.Num() == 0) {
+			return 0;
 		}
 
-		NewActor->PostEditChange();
-	}
-}
+		FRoseImportPhaseScope Scope(ERoseImportPhase::ActorSpawn);
 
-void FRoseImportModule::PluginButtonClicked()
-{
-	// GWarn->BeginSlowTask(NSLOCTEXT("RosePlugin", "SlowWorking", "We are working on importing the map!"), true);
+		// Without a transactor nothing is recorded, there is no reason to undo generated actors one at a time
+		TGuardValue<ITransaction*> UndoGuard(GUndo, nullptr);
 
-	// Put your "OnButtonClicked" stuff here
-	FText DialogText = FText::Format(
-							LOCTEXT("Rose Import", "Click Ok to start importing Rose Data"),
-							FText::FromString(TEXT("FRoseImportModule::PluginButtonClicked()")),
-							FText::FromString(TEXT("RoseImport.cpp"))
-					   );
-	FMessageDialog::Open(EAppMsgType::Ok, DialogText);
+		// The navigation octree picks up the whole batch when the lock is released instead of once per actor
+		FNavigationLockContext NavLock(world, ENavigationLockReason::Unknown);
 
-	const bool IMPORT_BUILDINGS = true;
-	const bool IMPORT_OBJECTS = true;
-	const bool IMPORT_COLLISIONS = false;
+		TArray<AActor*> spawned;
+		spawned.Init(NULL, pending.Num());
+		for (int32 i = 0; i < pending.Num(); ++i) {
+			FActorSpawnParameters SpawnInfo;
+			SpawnInfo.Name = pending[i].name;
+			SpawnInfo.bDeferConstruction = true;
+			SpawnInfo.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
 
-	if (IMPORT_BUILDINGS) {
-		Zsc meshsc(*(RoseBasePath + TEXT("3DDATA/JUNON/LIST_CNST_JDT.ZSC")));
-		for (int32 i = 0; i < meshsc.models.Num(); ++i) {
-			if (meshsc.models[i].parts.Num() > 0) {
-				ImportWorldZscModel("JDTC", meshsc, i);
-			}
+			// Each spawn still raises the editor's level actor added notification, the engine has no way to batch it
+			spawned[i] = world->SpawnActor<AActor>(pending[i].actorClass, pending[i].transform, SpawnInfo);
 		}
 
-		UE_LOG(LogTemp, Log, TEXT("[IMPORT_BUILDINGS] ZSC loaded: %d"), meshsc.models.Num());
-	}
-	if (IMPORT_OBJECTS) {
-		Zsc meshsd(*(RoseBasePath + TEXT("3DDATA/JUNON/LIST_DECO_JDT.ZSC")));
-		for (int32 i = 0; i < meshsd.models.Num(); ++i) {
-			if (meshsd.models[i].parts.Num() > 0) {
-				ImportWorldZscModel("JDTD", meshsd, i);
+		int32 finished = 0;
+		for (int32 i = 0; i < pending.Num(); ++i) {
+			if (spawned[i] != NULL) {
+				// Not a default transform, that would replace the IFO scale with the root template's
+				spawned[i]->FinishSpawning(pending[i].transform);
+				ApplyPartMaterials(spawned[i], pending[i].partMaterials);
+				if (clusterCellSize > 0.0f) {
+					clusters.FindOrAdd(pending[i].cluster).Add(spawned[i]);
+				}
+				++finished;
 			}
 		}
 
-		UE_LOG(LogTemp, Log, TEXT("[IMPORT_OBJECTS] ZSC loaded: %d"), meshsd.models.Num());
-	}	
-
-	const FString CnstPackageName = TEXT("/MAPS");
-
-	const float HIM_HEIGHT_MIN = -25600;
-	const float HIM_HEIGHT_MAX = +25600;
-	const float UEL_HEIGHT_WMIN = -25600;
-	const float UEL_HEIGHT_WMAX = +25600;
-	const float UEL_HEIGHT_MIN = 0x0000;
-	const float UEL_HEIGHT_MAX = 0x10000;
-	const float HIM_HEIGHT_MID = (HIM_HEIGHT_MAX - HIM_HEIGHT_MIN) / 2;
-	const float HIM_HEIGHT_MUL = (UEL_HEIGHT_MAX - UEL_HEIGHT_MIN) / (HIM_HEIGHT_MAX - HIM_HEIGHT_MIN);
-	const float UEL_ZSCALE = (UEL_HEIGHT_WMAX - UEL_HEIGHT_WMIN) / (HIM_HEIGHT_MAX - HIM_HEIGHT_MIN);
-
-	int startX = 31;
-	int startY = 30;
-	int endX = 34;
-	int endY = 33;
-
-	uint32 RoseSizeX = 4 * 16 * (endX - startX + 1);
-	uint32 RoseSizeY = 4 * 16 * (endY - startY + 1);
-	uint32 SizeX = (RoseSizeX / 63 + 1) * 63 + 1;
-	uint32 SizeY = (RoseSizeY / 63 + 1) * 63 + 1;
-	uint32 TileSizeX = SizeX;
-	uint32 TileSizeY = SizeY;
-
-	TArray<uint16> Data;
-	Data.AddZeroed(SizeX * SizeY);
-	for (int i = 0; i < Data.Num(); ++i) {
-		Data[i] = 0x8000;
+		pending.Reset();
+		return finished;
 	}
 
-	TArray<uint8> WeightData[8];
-	for (int32 i = 0; i < 8; ++i) {
-		WeightData[i].AddZeroed(TileSizeX * TileSizeY);
+	// Groups the spawned actors into square cells of CellSize starting at Origin, nothing is grouped by default
+	void SetClusterCells(const FVector2D& Origin, float CellSize) {
+		clusterOrigin = Origin;
+		clusterCellSize = CellSize;
 	}
 
-	float MinHeight = +1000000;
-	float MaxHeight = -1000000;
-	for (int iy = startY; iy <= endY; ++iy) {
-		for (int ix = startX; ix <= endX; ++ix) {
-			int outTileX = (ix - startX) * 16;
-			int outTileY = (iy - startY) * 16;
-			int outBaseX = (ix - startX) * 64;
-			int outBaseY = (iy - startY) * 64;
-
-			FString TilPath = FString::Printf(TEXT("3DDATA/MAPS/JUNON/JDT01/%d_%d.til"), ix, iy);
-			Til tilData(*(RoseBasePath + TilPath));
+	// Spawned actors by cell, complete once the batch has been flushed
+	const TMap<FIntPoint, TArray<AActor*>>& GetClusters() const {
+		return clusters;
+	}
 
-			for (int32 sy = 0; sy < 16; ++sy) {
-				for (int32 sx = 0; sx < 16; ++sx) {
-					int32 BrushIdx = tilData.Data[sy * 16 + sx].Brush;
-					check(BrushIdx >= 0 && BrushIdx < 8);
+private:
+	struct Placement {
+		FName name;
+		UClass* actorClass;
+		FTransform transform;
+		TArray<PartMaterial> partMaterials;
+		FIntPoint cluster;
+	};
 
-					for (int32 py = 0; py < 5; ++py) {
-						for (int32 px = 0; px < 5; ++px) {
-							int32 PixelX = (outTileX + sx) * 4 + px;
-							int32 PixelY = (outTileY + sy) * 4 + py;
+	static void ApplyPartMaterials(AActor* Actor, const TArray<PartMaterial>& PartMaterials) {
+		if (PartMaterials.Num() == 0) {
+			return;
+		}
 
-							WeightData[BrushIdx][PixelY * TileSizeX + PixelX] = 50;
-						}
-					}
+		TArray<UStaticMeshComponent*> MeshComps;
+		Actor->GetComponents<UStaticMeshComponent>(MeshComps);
+		for (UStaticMeshComponent* MeshComp : MeshComps) {
+			for (const PartMaterial& partMaterial : PartMaterials) {
+				int32 slot = MeshComp->ComponentTags.IndexOfByKey(GetPartTag(partMaterial.Key));
+				if (slot != INDEX_NONE) {
+					MeshComp->SetMaterial(slot, partMaterial.Value);
 				}
 			}
+		}
+	}
 
-			FString HimPath = FString::Printf(TEXT("3DDATA/MAPS/JUNON/JDT01/%d_%d.him"), ix, iy);
-			Him himData(*(RoseBasePath + HimPath));
-
-			for (int sy = 0; sy < 65; ++sy) {
-				for (int sx = 0; sx < 65; ++sx) {
-					int outIdx = (outBaseY + sy) * SizeX + (outBaseX + sx);
-					float hmValue = himData.heights[sy * 65 + sx];
-					float ueValue = FMath::Clamp(hmValue + 25600.0f, 0.0f, 51200.0f) / 51200.0f * 65535.0f;
-
-					Data[outIdx] = ueValue;
-
-					if (hmValue < MinHeight) {
-						MinHeight = hmValue;
-					}
-					if (hmValue > MaxHeight) {
-						MaxHeight = hmValue;
-					}
-				}
-			}
+	UWorld* world;
+	int32 batchSize;
+	TArray<Placement> pending;
 
+	FVector2D clusterOrigin;
+	float clusterCellSize;
+	TMap<FIntPoint, TArray<AActor*>> clusters;
+};
 
-			FString IfoPath = FString::Printf(TEXT("3DDATA/MAPS/JUNON/JDT01/%d_%d.ifo"), ix, iy);
-			Ifo ifoData(*(RoseBasePath + IfoPath));
+// One actor per region holding every collision block as an invisible box instance, no brushes or BSP involved
+AActor* SpawnCollisionInstances(UWorld* World, const FString& NewName, const TArray<Ifo::FCollisionBlock>& Collisions) {
+	FRoseImportPhaseScope Scope(ERoseImportPhase::ActorSpawn);
 
-			if (IMPORT_BUILDINGS) {
-				for (int32 i = 0; i < ifoData.Buildings.Num(); ++i) {
-					const Ifo::FBuildingBlock& obj = ifoData.Buildings[i];
-					FString ObjName = FString::Printf(TEXT("Bldg_%d_%d_%d"), ix, iy, i);
-					FString AssetName = FString::Printf(TEXT("JDTC_%d"), obj.ObjectID);
-					AActor* ObjActor = SpawnWorldModel(ObjName, CnstPackageName, AssetName, obj.Rotation, obj.Position, obj.Scale);
-				}
-			}
-			if (IMPORT_OBJECTS) {
-				for (int32 i = 0; i < ifoData.Objects.Num(); ++i) {
-					const Ifo::FObjectBlock& obj = ifoData.Objects[i];
-					FString ObjName = FString::Printf(TEXT("Deco_%d_%d_%d"), ix, iy, i);
-					FString AssetName = FString::Printf(TEXT("JDTD_%d"), obj.ObjectID);
-					AActor* ObjActor = SpawnWorldModel(ObjName, CnstPackageName, AssetName, obj.Rotation, obj.Position, obj.Scale);
-					if (ObjActor) {
-						ObjActor->SetActorScale3D(obj.Scale);
-					}
+	if (Collisions.Num() == 0) {
+		return NULL;
+	}
 
-				}
-			}
-			if (IMPORT_COLLISIONS) {
-				for (int32 i = 0; i < ifoData.Collisions.Num(); ++i) {
-					const Ifo::FCollisionBlock& obj = ifoData.Collisions[i];
+	// The engine cube is 100 units across and carries a simple box collision
+	UStaticMesh* BoxMesh = LoadObject<UStaticMesh>(NULL, TEXT("/Engine/BasicShapes/Cube.Cube"));
+	if (BoxMesh == NULL) {
+		return NULL;
+	}
 
-					FVector ColSize(120.0f * obj.Scale.X, 6.8f * obj.Scale.Y, 252.2f * obj.Scale.Z);
-					FVector RecenterPos =
-						FRotationTranslationMatrix(FRotator(obj.Rotation), FVector::ZeroVector)
-						.TransformPosition(FVector(0, 0, -ColSize.Z / 2));
+	TArray<FTransform> Instances;
+	Instances.Reserve(Collisions.Num());
+	for (int32 i = 0; i < Collisions.Num(); ++i) {
+		const Ifo::FCollisionBlock& obj = Collisions[i];
 
-					FActorSpawnParameters SpawnInfo;
-					SpawnInfo.Name = *FString::Printf(TEXT("Collision_%d_%d_%d"), ix, iy, i);
-					ABlockingVolume* ObjColl = GWorld->SpawnActor<ABlockingVolume>(
-						obj.Position - RecenterPos, FRotator(obj.Rotation), SpawnInfo);
+		FVector ColSize(120.0f * obj.Scale.X, 6.8f * obj.Scale.Y, 252.2f * obj.Scale.Z);
+		FVector RecenterPos =
+			FRotationTranslationMatrix(FRotator(obj.Rotation), FVector::ZeroVector)
+			.TransformPosition(FVector(0, 0, -ColSize.Z / 2));
 
-					if (ObjColl) {
-						UCubeBuilder* Builder = NewObject<UCubeBuilder>();
-						Builder->X = ColSize.X;
-						Builder->Y = ColSize.Y;
-						Builder->Z = ColSize.Z;
-						CreateBrushForVolumeActor(ObjColl, Builder);
+		Instances.Add(FTransform(obj.Rotation, obj.Position - RecenterPos, ColSize / 100.0f));
+	}
 
+	FActorSpawnParameters SpawnInfo;
+	SpawnInfo.Name = *NewName;
+	AActor* CollActor = World->SpawnActor<AActor>(AActor::StaticClass(), FTransform::Identity, SpawnInfo);
+	if (CollActor == NULL) {
+		return NULL;
+	}
 
-						
-						ObjColl->GetBrushComponent()->BuildSimpleBrushCollision();
-						if (ObjColl->GetBrushComponent()->IsPhysicsStateCreated()) {
-							ObjColl->GetBrushComponent()->RecreatePhysicsState();
-						}
+	UInstancedStaticMeshComponent* BoxComp = NewObject<UInstancedStaticMeshComponent>(CollActor, TEXT("CollisionBoxes"));
+	BoxComp->SetStaticMesh(BoxMesh);
+	BoxComp->SetMobility(EComponentMobility::Static);
+	BoxComp->SetVisibility(false);
+	BoxComp->SetHiddenInGame(true);
+	BoxComp->SetCastShadow(false);
+	BoxComp->SetCollisionEnabled(ECollisionEnabled::QueryAndPhysics);
+	BoxComp->SetCollisionResponseToAllChannels(ECR_Block);
+	BoxComp->SetCollisionResponseToChannel(ECC_Visibility, ECR_Ignore);
+	BoxComp->SetCollisionResponseToChannel(ECC_Camera, ECR_Ignore);
+	BoxComp->AddInstances(Instances, false);
+
+	CollActor->SetRootComponent(BoxComp);
+	CollActor->AddInstanceComponent(BoxComp);
+	BoxComp->RegisterComponent();
+
+	return CollActor;
+}
 
-						ObjColl->GetBrushComponent()->SetCollisionResponseToAllChannels(ECR_Block);
-						ObjColl->GetBrushComponent()->SetCollisionResponseToChannel(ECC_Visibility, ECR_Ignore);
-						ObjColl->GetBrushComponent()->SetCollisionResponseToChannel(ECC_Camera, ECR_Ignore);
-					}
-				}
-			}
-		}
+// Full weight layer of one TIL brush, only built for the moment the landscape takes it
+TArray<uint8> ExpandBrushLayer(const TArray<uint8>& BrushMasks, int32 BrushIdx)
+{
+	const uint8 Bit = 1 << BrushIdx;
+	TArray<uint8> LayerData;
+	LayerData.SetNumUninitialized(BrushMasks.Num());
+	for (int32 i = 0; i < BrushMasks.Num(); ++i) {
+		LayerData[i] = (BrushMasks[i] & Bit) ? 50 : 0;
 	}
+	return LayerData;
+}
 
-	UE_LOG(LogTemp, Log, TEXT("Imported map height bounds were: %f, %f"), MinHeight, MaxHeight);
+// BrushMasks holds a bit per TIL brush painted on each pixel, UsedBrushes the bits set anywhere in the zone
+ALandscape* ImportLandscape(UWorld* World, const TArray<uint16>& Data, const TArray<uint8>& BrushMasks, uint8 UsedBrushes, uint32 SizeX, uint32 SizeY, int startX, int startY)
+{
+	FRoseImportPhaseScope Scope(ERoseImportPhase::LandscapeImport);
 
 	FVector Location = FVector(0, 0, 0);
 	FRotator Rotation = FRotator(0, 0, 0);
-	ALandscape* Landscape = GWorld->SpawnActor<ALandscape>(Location, Rotation);
+	ALandscape* Landscape = World->SpawnActor<ALandscape>(Location, Rotation);
 	Landscape->PreEditChange(NULL);
 
 	Landscape->SetActorScale3D(FVector(250.0f, 250.0f, 51200.0f / 51200.0f * 100.0f));
@@ -1431,6 +2820,7 @@ void FRoseImportModule::PluginButtonClicked()
 
 
 	TArray<FLandscapeImportLayerInfo> LayerInfos;
+	TArray<FLandscapeImportLayerInfo> ImportLayerInfos;
 	auto LayerNames = Landscape->GetLayersFromMaterial();
 	for (int32 i = 0; i < LayerNames.Num(); ++i) {
 		const FName& LayerName = LayerNames[i];
@@ -1444,35 +2834,43 @@ void FRoseImportModule::PluginButtonClicked()
 		LIData->bNoWeightBlend = false;
 
 		// Notify the asset registry
-		FAssetRegistryModule::AssetCreated(LIData);
+		NotifyAssetCreated(LIData);
 
 		// Mark the package dirty...
 		LIPackage->MarkPackageDirty();
 
-		FLandscapeImportLayerInfo LayerInfo;
+		int32 BrushIdx;
 		if (LayerName.Compare(TEXT("Dirt")) == 0) {
-			LayerInfo.LayerData = WeightData[0];
+			BrushIdx = 0;
 			UE_LOG(LogTemp, Log, TEXT("Found Dirt Layer!"));
 		}
 		else if (LayerName.Compare(TEXT("Grass1")) == 0) {
-			LayerInfo.LayerData = WeightData[1];
+			BrushIdx = 1;
 			UE_LOG(LogTemp, Log, TEXT("Found Grass1 Layer!"));
 		}
 		else if (LayerName.Compare(TEXT("Grass2")) == 0) {
-			LayerInfo.LayerData = WeightData[3];
+			BrushIdx = 3;
 			UE_LOG(LogTemp, Log, TEXT("Found Grass2 Layer!"));
 		}
 		else if (LayerName.Compare(TEXT("Rock")) == 0) {
-			LayerInfo.LayerData = WeightData[5];
+			BrushIdx = 5;
 			UE_LOG(LogTemp, Log, TEXT("Found Rock Layer!"));
 		}
 		else {
-			LayerInfo.LayerData = WeightData[4];
+			BrushIdx = 4;
 			UE_LOG(LogTemp, Log, TEXT("Found Unknown Layer (%s)!"), *(LayerName.ToString()));
 		}
+
+		FLandscapeImportLayerInfo LayerInfo;
 		LayerInfo.LayerName = LayerName;
 		LayerInfo.LayerInfo = LIData;
 		LayerInfos.Add(LayerInfo);
+
+		// Brushes no tile paints stay registered for the editor but hand the import no data at all
+		if (UsedBrushes & (1 << BrushIdx)) {
+			LayerInfo.LayerData = ExpandBrushLayer(BrushMasks, BrushIdx);
+			ImportLayerInfos.Add(MoveTemp(LayerInfo));
+		}
 	}
 
 	ELandscapeImportAlphamapType p = ELandscapeImportAlphamapType::Additive;
@@ -1480,7 +2878,7 @@ void FRoseImportModule::PluginButtonClicked()
 	TMap<FGuid, TArray<FLandscapeImportLayerInfo>> MaterialLayerInfoMap;
 
 	HeightDataMap.Add(FGuid(), Data);
-	MaterialLayerInfoMap.Add(FGuid(), LayerInfos);
+	MaterialLayerInfoMap.Add(FGuid(), MoveTemp(ImportLayerInfos));
 	Landscape->Import(FGuid::NewGuid(), 0, 0, SizeX - 1, SizeY - 1, 1, 63, HeightDataMap, NULL, MaterialLayerInfoMap, p, nullptr);
 
 
@@ -1512,6 +2910,684 @@ void FRoseImportModule::PluginButtonClicked()
 	for (auto Component : Landscape->LandscapeComponents) {
 		Component->UpdateMaterialInstances();
 	}
+
+	return Landscape;
+}
+
+// A ZSC model list placed by one of the IFO object blocks, blueprints are named <typeName>_<model index>
+struct ZoneModelList {
+	ZoneModelList(const FString& _zscPath, const FString& _typeName, bool _buildings)
+		: zscPath(_zscPath), typeName(_typeName), buildings(_buildings) {}
+
+	// Resolved once per model, placements index straight into it instead of looking the blueprint up by name
+	UBlueprint* GetBlueprint(uint32 modelIdx) {
+		if (modelIdx >= (uint32)blueprints.Num()) {
+			return NULL;
+		}
+		if (!resolved[modelIdx]) {
+			SetBlueprint(modelIdx, GetExistingAsset<UBlueprint>(TEXT("/MAPS"), FString::Printf(TEXT("%s_%d"), *typeName, modelIdx)));
+		}
+		return blueprints[modelIdx];
+	}
+
+	void SetBlueprint(uint32 modelIdx, UBlueprint* blueprint) {
+		blueprints[modelIdx] = blueprint;
+		resolved[modelIdx] = true;
+	}
+
+	FString zscPath;
+	FString typeName;
+	bool buildings;
+	TSharedPtr<Zsc> zsc;
+	ZscPaths paths;
+
+	TArray<UBlueprint*> blueprints;
+	TArray<bool> resolved;
+};
+
+// Materials binding the baked lightmaps of one IFO block to the parts of its model that use them
+TArray<WorldPlacementBatch::PartMaterial> GetLightmapMaterials(const ZoneModelList& list, const Lit* litData, const FString& LitPath, int32 blockIdx, uint32 modelIdx) {
+	TArray<WorldPlacementBatch::PartMaterial> partMaterials;
+	if (litData == NULL || modelIdx >= (uint32)list.zsc->models.Num()) {
+		return partMaterials;
+	}
+
+	const Lit::Object* litObject = litData->FindObject(blockIdx);
+	if (litObject == NULL) {
+		return partMaterials;
+	}
+
+	FString LightmapPackage, LitName;
+	BuildAssetPath(LightmapPackage, LitName, LitPath);
+
+	const Zsc::Model& model = list.zsc->models[modelIdx];
+	for (const Lit::Part& litPart : litObject->parts) {
+		if (litPart.partIdx < 0 || litPart.partIdx >= model.parts.Num() || !model.parts[litPart.partIdx].useLightmap) {
+			continue;
+		}
+
+		UTexture* Lightmap = ImportRoseTexture(FPaths::GetPath(LitPath) / litPart.ddsName);
+		if (Lightmap == NULL) {
+			continue;
+		}
+
+		const Zsc::Part& part = model.parts[litPart.partIdx];
+		UTexture* Texture = ImportRoseTexture(list.paths.textures[part.texIdx]);
+
+		// Named by lightmap cell rather than placement, so placements sharing a cell share the instance. The texture is
+		// named by its list and entry, one file can be listed from several folders or with different render states
+		FString MaterialName = FString::Printf(TEXT("%s_%d_%d_%s_%d_LM"), *FPaths::GetBaseFilename(litPart.ddsName),
+			litPart.partsPerWidth, litPart.partPosition, *list.typeName, part.texIdx);
+		UMaterialInterface* Material = ImportLightmapMaterial(LightmapPackage, MaterialName, list.zsc->textures[part.texIdx], Texture, Lightmap, litPart.GetScaleBias());
+		if (Material != NULL) {
+			partMaterials.Add(WorldPlacementBatch::PartMaterial(litPart.partIdx, Material));
+		}
+	}
+	return partMaterials;
+}
+
+int32 AddGraphFile(FRoseImportGraph& graph, ERoseNodeKind::Type Kind, const FString& RosePath, int32 ItemIdx = INDEX_NONE) {
+	FString Key = NormalizeRosePath(RosePath);
+	int32 Existing = graph.FindNode(Kind, Key);
+	if (Existing != INDEX_NONE) {
+		return Existing;
+	}
+	return graph.AddNode(Kind, Key, INDEX_NONE, ItemIdx, FMath::Max<int64>(IFileManager::Get().FileSize(*(RoseBasePath + RosePath)), 0));
+}
+
+// Loads each ZSC model list once, zones placing models from the same list share its blueprints
+int32 AddModelList(TArray<ZoneModelList>& modelLists, const FString& zscPath, const FString& typeName, bool buildings) {
+	for (int32 i = 0; i < modelLists.Num(); ++i) {
+		if (modelLists[i].zscPath == zscPath && modelLists[i].buildings == buildings) {
+			return i;
+		}
+	}
+
+	ZoneModelList& list = modelLists.Add_GetRef(ZoneModelList(zscPath, typeName, buildings));
+	list.zsc = ParseRoseFile<Zsc>(zscPath);
+	list.paths = ZscPaths(*list.zsc);
+	list.blueprints.Init(NULL, list.zsc->models.Num());
+	list.resolved.Init(false, list.zsc->models.Num());
+	return modelLists.Num() - 1;
+}
+
+struct ZoneImportOptions {
+	bool collisions;
+	bool lightmaps;
+	// Cluster the placed models into LOD actors with simplified proxy meshes
+	bool hlod;
+	// Clusters along each side of a tile, 1 gives one cluster per tile
+	int32 hlodCellsPerTile;
+	ImportModelOptions model;
+};
+
+// One map of an import, with the terrain it accumulates and the world its actors are placed in
+struct ZoneImport {
+	ZoneImport(const FString& _zonPath)
+		: zonPath(_zonPath), mapPath(FPaths::GetPath(_zonPath)), world(NULL), usedBrushes(0), minHeight(+1000000), maxHeight(-1000000), cost(0) {}
+
+	// Reads the ZON and sizes the terrain for the tiles it found, false when there are none
+	bool Prepare() {
+		zone = ParseRoseFile<Zon>(zonPath);
+		if (!zone->GetTileBounds(startX, startY, endX, endY)) {
+			return false;
+		}
+
+		uint32 RoseSizeX = 4 * 16 * (endX - startX + 1);
+		uint32 RoseSizeY = 4 * 16 * (endY - startY + 1);
+		sizeX = (RoseSizeX / 63 + 1) * 63 + 1;
+		sizeY = (RoseSizeY / 63 + 1) * 63 + 1;
+
+		heights.Init(0x8000, sizeX * sizeY);
+		brushMasks.AddZeroed(sizeX * sizeY);
+
+		// Models are shared between zones, so only the tile files count towards what a zone costs on its own
+		const TCHAR* Extensions[] = { TEXT("him"), TEXT("til"), TEXT("ifo") };
+		for (const Zon::FTileFiles& tile : zone->TileFiles) {
+			for (const TCHAR* Extension : Extensions) {
+				cost += FMath::Max<int64>(IFileManager::Get().FileSize(*(RoseBasePath + GetTilePath(tile, Extension))), 0);
+			}
+		}
+		return true;
+	}
+
+	void SetWorld(UWorld* _world) {
+		world = _world;
+		placements = MakeShareable(new WorldPlacementBatch(world));
+	}
+
+	FString GetTilePath(const Zon::FTileFiles& tile, const TCHAR* Extension) const {
+		return mapPath / FString::Printf(TEXT("%d_%d.%s"), tile.X, tile.Y, Extension);
+	}
+
+	// Corner of the first tile, where ImportLandscape puts the terrain
+	FVector2D GetOrigin() const {
+		return FVector2D((startX - 32) * 16000 - 8000, (startY - 32) * 16000 - 8000);
+	}
+
+	FString zonPath;
+	FString mapPath;
+	TSharedPtr<Zon> zone;
+	TArray<int32> modelLists;
+
+	UWorld* world;
+	TSharedPtr<WorldPlacementBatch> placements;
+
+	int startX, startY, endX, endY;
+	uint32 sizeX, sizeY;
+	TArray<uint16> heights;
+	// A bit per TIL brush painted on the pixel, the weight layers are only expanded for the brushes in usedBrushes
+	TArray<uint8> brushMasks;
+	uint8 usedBrushes;
+	float minHeight;
+	float maxHeight;
+
+	int64 cost;
+};
+
+// A world asset of its own for a zone, saved with the rest of the zone's packages
+UWorld* CreateZoneWorld(const FString& ZonPath) {
+	FString PackageName, WorldName;
+	BuildAssetPath(PackageName, WorldName, ZonPath);
+
+	UPackage* Package = GetOrMakePackage(PackageName, WorldName);
+	if (Package == NULL) {
+		return NULL;
+	}
+
+	UWorldFactory* Factory = NewObject<UWorldFactory>();
+	Factory->WorldType = EWorldType::Inactive;
+	UWorld* World = Cast<UWorld>(Factory->FactoryCreateNew(UWorld::StaticClass(), Package, *WorldName, RF_Public | RF_Standalone, NULL, GWarn));
+	if (World != NULL) {
+		// Kept from the saver until FinishZone, a save at an earlier boundary would write the map before it is filled
+		FAssetRegistryModule::AssetCreated(World);
+		GetAssetCache().Add(World);
+		FRoseImportStats::Get().Increment(ERoseImportCounter::AssetsCreated);
+		World->MarkPackageDirty();
+	}
+	return World;
+}
+
+// Builds zone -> tiles -> IFO -> models -> ZMS/ZMO/textures for every zone before anything is imported. The IFOs
+// are parsed here since they decide which models are needed, everything else is left to the scheduler.
+bool ScanZones(FRoseImportGraph& graph, ImportParseCache& parsed, TArray<ZoneModelList>& modelLists, const TArray<ZoneImport>& zones) {
+	// The tile directories say exactly which files exist, so every per-tile table is sized once up front
+	int32 tileCount = 0;
+	for (const ZoneImport& zi : zones) {
+		tileCount += zi.zone->TileFiles.Num();
+	}
+	parsed.ifo.Reserve(tileCount);
+	parsed.him.Reserve(tileCount);
+	parsed.til.Reserve(tileCount);
+
+	// IFOs of all zones in one batch, so small zones do not leave workers idle
+	TArray<FString> ifoPaths;
+	ifoPaths.Reserve(tileCount);
+	for (const ZoneImport& zi : zones) {
+		for (const Zon::FTileFiles& tile : zi.zone->TileFiles) {
+			if (tile.HasIfo) {
+				ifoPaths.Add(zi.GetTilePath(tile, TEXT("ifo")));
+			}
+		}
+	}
+	ParseUniqueFiles(ifoPaths, parsed.ifo);
+
+	for (int32 z = 0; z < zones.Num(); ++z) {
+		const ZoneImport& zi = zones[z];
+		int32 zoneNode = graph.AddNode(ERoseNodeKind::Zone, NormalizeRosePath(zi.mapPath), z);
+
+		for (int32 t = 0; t < zi.zone->TileFiles.Num(); ++t) {
+			const Zon::FTileFiles& tile = zi.zone->TileFiles[t];
+			int32 tileNode = graph.AddNode(ERoseNodeKind::Tile, NormalizeRosePath(zi.mapPath / FString::Printf(TEXT("%d_%d"), tile.X, tile.Y)), z, t);
+			graph.AddDependency(zoneNode, tileNode);
+
+			if (tile.HasHim) {
+				graph.AddDependency(tileNode, AddGraphFile(graph, ERoseNodeKind::Him, zi.GetTilePath(tile, TEXT("him"))));
+			}
+			if (tile.HasTil) {
+				graph.AddDependency(tileNode, AddGraphFile(graph, ERoseNodeKind::Til, zi.GetTilePath(tile, TEXT("til"))));
+			}
+			if (!tile.HasIfo) {
+				continue;
+			}
+
+			const FString IfoPath = zi.GetTilePath(tile, TEXT("ifo"));
+			int32 ifoNode = AddGraphFile(graph, ERoseNodeKind::Ifo, IfoPath);
+			graph.AddDependency(tileNode, ifoNode);
+
+			const TSharedPtr<Ifo>& ifoParsed = parsed.ifo[NormalizeRosePath(IfoPath)];
+			if (!IsUsable(ifoParsed)) {
+				continue;
+			}
+
+			const Ifo& ifoData = *ifoParsed;
+			for (int32 l : zi.modelLists) {
+				const ZoneModelList& list = modelLists[l];
+				TArray<uint32> objectIds;
+				if (list.buildings) {
+					for (const Ifo::FBuildingBlock& obj : ifoData.GetBuildings()) {
+						objectIds.AddUnique(obj.ObjectID);
+					}
+				}
+				else {
+					for (const Ifo::FObjectBlock& obj : ifoData.GetObjects()) {
+						objectIds.AddUnique(obj.ObjectID);
+					}
+				}
+
+				for (uint32 modelIdx : objectIds) {
+					if (modelIdx >= (uint32)list.zsc->models.Num() || list.zsc->models[modelIdx].parts.Num() == 0) {
+						continue;
+					}
+
+					FString ModelName = FString::Printf(TEXT("%s_%d"), *list.typeName, modelIdx);
+					int32 modelNode = graph.FindNode(ERoseNodeKind::Model, ModelName);
+					if (modelNode == INDEX_NONE) {
+						modelNode = graph.AddNode(ERoseNodeKind::Model, ModelName, l, modelIdx);
+
+						for (const Zsc::Part& part : list.zsc->models[modelIdx].parts) {
+							graph.AddDependency(modelNode, AddGraphFile(graph, ERoseNodeKind::Zms, list.zsc->meshes[part.meshIdx]));
+							// Texture nodes carry their path handle so the import step never splits the path again
+							graph.AddDependency(modelNode, AddGraphFile(graph, ERoseNodeKind::Texture, list.zsc->textures[part.texIdx].filePath, list.paths.textures[part.texIdx]));
+							if (!part.animPath.IsEmpty()) {
+								graph.AddDependency(modelNode, AddGraphFile(graph, ERoseNodeKind::Zmo, part.animPath));
+							}
+						}
+					}
+					graph.AddDependency(ifoNode, modelNode);
+				}
+			}
+		}
+	}
+
+	return graph.Finalize();
+}
+
+// Writes one tile's heights and layer weights into the zone's terrain and places its IFO objects
+void ImportZoneTile(ZoneImport& zi, const Zon::FTileFiles& tile, TArray<ZoneModelList>& modelLists, ImportParseCache& parsed, const ZoneImportOptions& options) {
+	const int ix = tile.X;
+	const int iy = tile.Y;
+	int outTileX = (ix - zi.startX) * 16;
+	int outTileY = (iy - zi.startY) * 16;
+	int outBaseX = (ix - zi.startX) * 64;
+	int outBaseY = (iy - zi.startY) * 64;
+
+	TSharedPtr<Til> tilData = tile.HasTil ? GetOrParseFile(parsed.til, zi.GetTilePath(tile, TEXT("til"))) : TSharedPtr<Til>();
+
+	for (int32 sy = 0; IsUsable(tilData) && sy < 16; ++sy) {
+		for (int32 sx = 0; sx < 16; ++sx) {
+			int32 BrushIdx = tilData->Data[sy * 16 + sx].Brush;
+			check(BrushIdx >= 0 && BrushIdx < 8);
+			zi.usedBrushes |= 1 << BrushIdx;
+
+			for (int32 py = 0; py < 5; ++py) {
+				for (int32 px = 0; px < 5; ++px) {
+					int32 PixelX = (outTileX + sx) * 4 + px;
+					int32 PixelY = (outTileY + sy) * 4 + py;
+
+					zi.brushMasks[PixelY * zi.sizeX + PixelX] |= 1 << BrushIdx;
+				}
+			}
+		}
+	}
+
+	TSharedPtr<Him> himData = tile.HasHim ? GetOrParseFile(parsed.him, zi.GetTilePath(tile, TEXT("him"))) : TSharedPtr<Him>();
+
+	for (int sy = 0; IsUsable(himData) && sy < 65; ++sy) {
+		for (int sx = 0; sx < 65; ++sx) {
+			int outIdx = (outBaseY + sy) * zi.sizeX + (outBaseX + sx);
+			float hmValue = himData->heights[sy * 65 + sx];
+			float ueValue = FMath::Clamp(hmValue + 25600.0f, 0.0f, 51200.0f) / 51200.0f * 65535.0f;
+
+			zi.heights[outIdx] = ueValue;
+
+			if (hmValue < zi.minHeight) {
+				zi.minHeight = hmValue;
+			}
+			if (hmValue > zi.maxHeight) {
+				zi.maxHeight = hmValue;
+			}
+		}
+	}
+
+	if (!tile.HasIfo) {
+		return;
+	}
+
+	TSharedPtr<Ifo> ifoData = GetOrParseFile(parsed.ifo, zi.GetTilePath(tile, TEXT("ifo")));
+	if (!IsUsable(ifoData)) {
+		return;
+	}
+
+	for (int32 l : zi.modelLists) {
+		ZoneModelList& list = modelLists[l];
+
+		// Baked lightmaps sit next to the tile, one LIT per IFO list indexing the atlases in the same folder
+		FString LitPath = zi.mapPath / FString::Printf(TEXT("%d_%d/LIGHTMAP/%s"), ix, iy,
+			list.buildings ? TEXT("BUILDINGLIGHTMAPDATA.LIT") : TEXT("OBJECTLIGHTMAPDATA.LIT"));
+		TSharedPtr<Lit> litData;
+		if (options.lightmaps && IFileManager::Get().FileExists(*(RoseBasePath + LitPath))) {
+			litData = GetOrParseFile(parsed.lit, LitPath);
+		}
+
+		if (list.buildings) {
+			const TArray<Ifo::FBuildingBlock>& blocks = ifoData->GetBuildings();
+			for (int32 i = 0; i < blocks.Num(); ++i) {
+				const Ifo::FBuildingBlock& obj = blocks[i];
+				FString ObjName = FString::Printf(TEXT("Bldg_%d_%d_%d"), ix, iy, i);
+				zi.placements->Add(ObjName, list.GetBlueprint(obj.ObjectID), obj.Rotation, obj.Position, obj.Scale,
+					GetLightmapMaterials(list, litData.Get(), LitPath, i, obj.ObjectID));
+			}
+		}
+		else {
+			const TArray<Ifo::FObjectBlock>& blocks = ifoData->GetObjects();
+			for (int32 i = 0; i < blocks.Num(); ++i) {
+				const Ifo::FObjectBlock& obj = blocks[i];
+				FString ObjName = FString::Printf(TEXT("Deco_%d_%d_%d"), ix, iy, i);
+				zi.placements->Add(ObjName, list.GetBlueprint(obj.ObjectID), obj.Rotation, obj.Position, obj.Scale,
+					GetLightmapMaterials(list, litData.Get(), LitPath, i, obj.ObjectID));
+			}
+		}
+	}
+	if (options.collisions) {
+		FString CollName = FString::Printf(TEXT("Collision_%d_%d"), ix, iy);
+		SpawnCollisionInstances(zi.world, CollName, ifoData->GetCollisions());
+	}
+}
+
+// One LOD actor per cluster of placements, each with a merged and simplified proxy of its static parts and the
+// materials baked down to a single one. Animated parts are movable and stay out of the proxies.
+void BuildZoneHlod(ZoneImport& zi) {
+	FRoseImportPhaseScope Scope(ERoseImportPhase::HlodBuild);
+
+	AWorldSettings* WorldSettings = zi.world->GetWorldSettings();
+	WorldSettings->bEnableHierarchicalLODSystem = true;
+	TArray<FHierarchicalSimplification>& LODSetup = WorldSettings->GetHierarchicalLODSetup();
+	if (LODSetup.Num() == 0) {
+		LODSetup.AddDefaulted();
+	}
+
+	FHierarchicalSimplification& Simplification = LODSetup[0];
+	Simplification.bSimplifyMesh = true;
+	Simplification.TransitionScreenSize = 0.25f;
+	Simplification.MinNumberOfActorsToBuild = 2;
+	Simplification.ProxySetting.MaterialSettings.TextureSize = FIntPoint(512, 512);
+
+	FHierarchicalLODUtilitiesModule& Module = FModuleManager::LoadModuleChecked<FHierarchicalLODUtilitiesModule>("HierarchicalLODUtilities");
+	IHierarchicalLODUtilities* Utilities = Module.GetUtilities();
+	UPackage* AssetsOuter = Utilities->CreateOrRetrieveLevelHLODPackage(zi.world->PersistentLevel, 0);
+	// The proxies live in a package of their own next to the map, it has to be saved before the world is torn down
+	if (ImportSaver != NULL) {
+		ImportSaver->Add(AssetsOuter);
+	}
+	UMaterialInterface* BaseMaterial = WorldSettings->GetHierarchicalLODBaseMaterial();
+
+	// Each cluster's proxy is only queued here, the engine's proxy processor reduces it asynchronously and assigns the
+	// mesh to its LOD actor when it ticks on the game thread
+	TArray<ALODActor*> LODActors;
+	for (const auto& Cluster : zi.placements->GetClusters()) {
+		if (Cluster.Value.Num() < Simplification.MinNumberOfActorsToBuild) {
+			continue;
+		}
+
+		ALODActor* LODActor = Utilities->CreateNewClusterActor(zi.world, 0, WorldSettings);
+		if (LODActor == NULL) {
+			continue;
+		}
+		for (AActor* Actor : Cluster.Value) {
+			LODActor->AddSubActor(Actor);
+		}
+		LODActors.Add(LODActor);
+	}
+
+	TArray<ALODActor*> queued;
+	for (ALODActor* LODActor : LODActors) {
+		if (Utilities->BuildStaticMeshForLODActor(LODActor, AssetsOuter, Simplification, BaseMaterial)) {
+			queued.Add(LODActor);
+		}
+	}
+
+	// Nothing else ticks the processor while the import holds the game thread, the proxies have to be in before the
+	// zone is saved and torn down
+	auto isPending = [](ALODActor* LODActor) { return LODActor->IsDirty(); };
+	const double deadline = FPlatformTime::Seconds() + 30.0 * 60.0;
+	while (queued.ContainsByPredicate(isPending) && FPlatformTime::Seconds() < deadline) {
+		FTaskGraphInterface::Get().ProcessThreadUntilIdle(ENamedThreads::GameThread);
+		FTickableEditorObject::TickObjects(0.01f);
+		FPlatformProcess::Sleep(0.01f);
+	}
+
+	const int32 pending = queued.FilterByPredicate(isPending).Num();
+	if (pending > 0) {
+		UE_LOG(LogTemp, Warning, TEXT("%s: gave up waiting for %d HLOD proxies"), *zi.mapPath, pending);
+	}
+	UE_LOG(LogTemp, Log, TEXT("%s: built %d of %d HLOD proxies"), *zi.mapPath, queued.Num() - pending, LODActors.Num());
+}
+
+// Every tile of the zone is in, what is left is its landscape
+void FinishZone(ZoneImport& zi, const ZoneImportOptions& options) {
+	zi.placements->Flush();
+	if (options.hlod) {
+		BuildZoneHlod(zi);
+	}
+	UE_LOG(LogTemp, Log, TEXT("%s: imported map height bounds were: %f, %f"), *zi.mapPath, zi.minHeight, zi.maxHeight);
+
+	ImportLandscape(zi.world, zi.heights, zi.brushMasks, zi.usedBrushes, zi.sizeX, zi.sizeY, zi.startX, zi.startY);
+
+	// The terrain buffers are the bulk of a zone, a whole world import cannot keep them for every zone
+	zi.heights.Empty();
+	zi.brushMasks.Empty();
+
+	// A zone world of its own is done with once saved, tearing it down keeps the editor from holding every zone
+	if (zi.world != GWorld && ImportSaver != NULL) {
+		ImportSaver->Add(zi.world->GetOutermost());
+		ImportSaver->SaveDirty();
+		zi.world->DestroyWorld(false);
+		zi.world->ClearFlags(RF_Standalone);
+		zi.world = NULL;
+	}
+}
+
+// Runs the graph level by level, parsing each level on the task graph and creating its UObjects on the game thread
+void ImportZones(FRoseImportGraph& graph, ImportParseCache& parsed, TArray<ZoneModelList>& modelLists, TArray<ZoneImport>& zones, const ZoneImportOptions& options) {
+	// Leaves first, every level only depends on the ones before it
+	const TArray<TArray<int32>>& levels = graph.GetLevels();
+	for (int32 l = 0; l < levels.Num(); ++l) {
+		// Largest first, so the last tasks a level hands out are short and the workers finish together
+		TArray<int32> level = levels[l];
+		level.Sort([&graph](int32 A, int32 B) { return graph.GetNode(A).Cost > graph.GetNode(B).Cost; });
+
+		// Files within a level never depend on each other, so they are all parsed at once on the task graph
+		TArray<FString> parsePaths[ERoseNodeKind::Num];
+		for (int32 NodeIdx : level) {
+			const FRoseImportGraph::FNode& Node = graph.GetNode(NodeIdx);
+			parsePaths[Node.Kind].Add(Node.Key);
+		}
+		ParseUniqueFiles(parsePaths[ERoseNodeKind::Zms], parsed.zms);
+		ParseUniqueFiles(parsePaths[ERoseNodeKind::Zmo], parsed.zmo);
+		ParseUniqueFiles(parsePaths[ERoseNodeKind::Him], parsed.him);
+		ParseUniqueFiles(parsePaths[ERoseNodeKind::Til], parsed.til);
+
+		// Assets and actors are UObjects and are created on the game thread
+		for (int32 NodeIdx : level) {
+			const FRoseImportGraph::FNode& Node = graph.GetNode(NodeIdx);
+			if (Node.Kind == ERoseNodeKind::Texture) {
+				// Atlased textures are imported on their own only if a part turns out not to fit its cell
+				if (options.model.atlases == NULL || !options.model.atlases->Contains(Node.ItemIdx)) {
+					ImportRoseTexture(Node.ItemIdx);
+				}
+			}
+			else if (Node.Kind == ERoseNodeKind::Model) {
+				ZoneModelList& list = modelLists[Node.ListIdx];
+				list.SetBlueprint(Node.ItemIdx, ImportWorldZscModel(list.typeName, *list.zsc, list.paths, Node.ItemIdx, options.model, parsed));
+			}
+			else if (Node.Kind == ERoseNodeKind::Tile) {
+				ZoneImport& zi = zones[Node.ListIdx];
+				ImportZoneTile(zi, zi.zone->TileFiles[Node.ItemIdx], modelLists, parsed, options);
+			}
+			else if (Node.Kind == ERoseNodeKind::Zone) {
+				FinishZone(zones[Node.ListIdx], options);
+			}
+		}
+
+		// The writes run on workers while the next level parses, a level's packages are complete once it is done
+		if (ImportSaver != NULL) {
+			ImportSaver->SaveDirty();
+		}
+	}
+}
+
+void FRoseImportModule::PluginButtonClicked()
+{
+	// GWarn->BeginSlowTask(NSLOCTEXT("RosePlugin", "SlowWorking", "We are working on importing the map!"), true);
+
+	// Put your "OnButtonClicked" stuff here
+	FText DialogText = FText::Format(
+							LOCTEXT("Rose Import", "Click Ok to start importing Rose Data"),
+							FText::FromString(TEXT("FRoseImportModule::PluginButtonClicked()")),
+							FText::FromString(TEXT("RoseImport.cpp"))
+					   );
+	FMessageDialog::Open(EAppMsgType::Ok, DialogText);
+
+	FRoseImportStats::Get().Reset();
+	GetAssetCache().Populate();
+	GetTextureContentCache().Load();
+
+	const bool IMPORT_BUILDINGS = true;
+	const bool IMPORT_OBJECTS = true;
+	const bool IMPORT_COLLISIONS = true;
+	const bool IMPORT_CHARS = false;
+	const bool IMPORT_LIGHTMAPS = true;
+	const bool IMPORT_ZONE_LIST = false;
+	const bool ATLAS_SMALL_TEXTURES = false;
+	const bool BUILD_HLOD = false;
+	const bool SAVE_PACKAGES = false;
+
+	ZoneImportOptions options;
+	options.collisions = IMPORT_COLLISIONS;
+	options.lightmaps = IMPORT_LIGHTMAPS;
+	options.hlod = BUILD_HLOD;
+	options.hlodCellsPerTile = 2;
+	options.model.mergeStaticParts = true;
+	options.model.convexDecomposition = false;
+
+	// The saver flushes when it goes out of scope, the guard clears the global first on every way out
+	FRoseImportSaver saver;
+	TGuardValue<FRoseImportSaver*> SaverGuard(ImportSaver, SAVE_PACKAGES ? &saver : NULL);
+
+	if (IMPORT_CHARS) {
+		TSharedPtr<Chr> npcChars = ParseRoseFile<Chr>(TEXT("3DDATA/NPC/LIST_NPC.CHR"));
+		TSharedPtr<Zsc> npcParts = ParseRoseFile<Zsc>(TEXT("3DDATA/NPC/PART_NPC.ZSC"));
+		SkeletonCache skeletons;
+		AnimCompressSettings npcAnimSettings(TEXT("NPC"));
+		ImportChars(*npcChars, *npcParts, skeletons, npcAnimSettings);
+
+		UE_LOG(LogTemp, Log, TEXT("[IMPORT_CHARS] CHR loaded: %d"), npcChars->characters.Num());
+
+		if (ImportSaver != NULL) {
+			ImportSaver->SaveDirty();
+		}
+	}
+
+	// Model lists are shared by every zone that places from them, zones only hold indices into it
+	TArray<ZoneModelList> modelLists;
+	TArray<ZoneImport> zones;
+	if (IMPORT_ZONE_LIST) {
+		// Every zone the client lists, column 1 names its ZON and columns 11 and 12 its deco and construction lists
+		TSharedPtr<Stb> zoneList = ParseRoseFile<Stb>(TEXT("3DDATA/STB/LIST_ZONE.STB"));
+		for (int32 row = 0; row < zoneList->GetRowCount(); ++row) {
+			FString ZonPath = zoneList->GetCell(row, 1);
+			FPaths::NormalizeFilename(ZonPath);
+			if (ZonPath.IsEmpty() || !IFileManager::Get().FileExists(*(RoseBasePath + ZonPath))) {
+				continue;
+			}
+
+			ZoneImport& zi = zones.Add_GetRef(ZoneImport(ZonPath));
+			FString DecoPath = zoneList->GetCell(row, 11);
+			FString CnstPath = zoneList->GetCell(row, 12);
+			FPaths::NormalizeFilename(DecoPath);
+			FPaths::NormalizeFilename(CnstPath);
+			if (IMPORT_BUILDINGS && !CnstPath.IsEmpty()) {
+				zi.modelLists.Add(AddModelList(modelLists, CnstPath, FPaths::GetBaseFilename(CnstPath), true));
+			}
+			if (IMPORT_OBJECTS && !DecoPath.IsEmpty()) {
+				zi.modelLists.Add(AddModelList(modelLists, DecoPath, FPaths::GetBaseFilename(DecoPath), false));
+			}
+		}
+	}
+	else {
+		ZoneImport& zi = zones.Add_GetRef(ZoneImport(TEXT("3DDATA/MAPS/JUNON/JDT01/JDT01.ZON")));
+		if (IMPORT_BUILDINGS) {
+			zi.modelLists.Add(AddModelList(modelLists, TEXT("3DDATA/JUNON/LIST_CNST_JDT.ZSC"), TEXT("JDTC"), true));
+		}
+		if (IMPORT_OBJECTS) {
+			zi.modelLists.Add(AddModelList(modelLists, TEXT("3DDATA/JUNON/LIST_DECO_JDT.ZSC"), TEXT("JDTD"), false));
+		}
+	}
+
+	// Everything each zone has on disk, rather than a guessed rectangle
+	for (int32 z = zones.Num() - 1; z >= 0; --z) {
+		if (!zones[z].Prepare()) {
+			UE_LOG(LogTemp, Warning, TEXT("No tiles found for %s"), *zones[z].mapPath);
+			zones.RemoveAt(z);
+		}
+	}
+	if (zones.Num() == 0) {
+		UE_LOG(LogTemp, Error, TEXT("No zones to import"));
+		FRoseImportStats::Get().StopSampling();
+		return;
+	}
+
+	// The costliest zones enter the graph first, so their files lead every level
+	zones.Sort([](const ZoneImport& A, const ZoneImport& B) { return A.cost > B.cost; });
+	for (ZoneImport& zi : zones) {
+		zi.SetWorld(IMPORT_ZONE_LIST ? CreateZoneWorld(zi.zonPath) : GWorld);
+		if (options.hlod && zi.world != NULL) {
+			zi.placements->SetClusterCells(zi.GetOrigin(), 16000.0f / options.hlodCellsPerTile);
+		}
+		UE_LOG(LogTemp, Log, TEXT("%s: %d tiles in %d_%d to %d_%d, %.2f MB"), *zi.mapPath, zi.zone->TileFiles.Num(),
+			zi.startX, zi.startY, zi.endX, zi.endY, zi.cost / (1024.0 * 1024.0));
+	}
+	zones.RemoveAll([](const ZoneImport& zi) { return zi.world == NULL; });
+
+	ImportParseCache parsed;
+	FRoseImportGraph graph;
+	if (!ScanZones(graph, parsed, modelLists, zones)) {
+		FRoseImportStats::Get().StopSampling();
+		return;
+	}
+	graph.LogSummary();
+
+	TextureAtlasSet atlases;
+	if (ATLAS_SMALL_TEXTURES) {
+		// Deco textures of the models the zones place, buildings are mostly large tiling textures
+		for (int32 NodeIdx = 0; NodeIdx < graph.Num(); ++NodeIdx) {
+			const FRoseImportGraph::FNode& Node = graph.GetNode(NodeIdx);
+			if (Node.Kind != ERoseNodeKind::Model || modelLists[Node.ListIdx].buildings) {
+				continue;
+			}
+
+			const ZoneModelList& list = modelLists[Node.ListIdx];
+			for (const Zsc::Part& part : list.zsc->models[Node.ItemIdx].parts) {
+				if (!part.useLightmap) {
+					atlases.AddCandidate(list.paths.textures[part.texIdx], list.zsc->textures[part.texIdx]);
+				}
+			}
+		}
+		atlases.Build();
+		options.model.atlases = &atlases;
+	}
+
+	ImportZones(graph, parsed, modelLists, zones, options);
+
+	if (ImportSaver != NULL) {
+		ImportSaver->SaveDirty();
+		ImportSaver->Flush();
+		UE_LOG(LogTemp, Log, TEXT("Saved %d packages, %.2f MB"), saver.GetSavedCount(), saver.GetSavedBytes() / (1024.0 * 1024.0));
+	}
+
+	GetTextureContentCache().Save();
+	FRoseImportStats::Get().WriteReport();
 }
 
 void FRoseImportModule::AddMenuExtension(FMenuBuilder& Builder)
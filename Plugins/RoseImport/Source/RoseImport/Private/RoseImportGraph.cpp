@@ -0,0 +1,184 @@
+#include "RoseImportGraph.h"
+
+int32 FRoseImportGraph::AddNode(ERoseNodeKind::Type Kind, const FString& Key, int32 ListIdx, int32 ItemIdx, int64 Cost)
+{
+	int32* Existing = NodeLookup[Kind].Find(Key);
+	if (Existing)
+	{
+		return *Existing;
+	}
+
+	FNode Node;
+	Node.Kind = Kind;
+	Node.Key = Key;
+	Node.ListIdx = ListIdx;
+	Node.ItemIdx = ItemIdx;
+	Node.Cost = Cost;
+	Node.Level = 0;
+
+	int32 NodeIdx = Nodes.Add(Node);
+	NodeLookup[Kind].Add(Key, NodeIdx);
+	return NodeIdx;
+}
+
+int32 FRoseImportGraph::FindNode(ERoseNodeKind::Type Kind, const FString& Key) const
+{
+	const int32* Existing = NodeLookup[Kind].Find(Key);
+	return Existing ? *Existing : INDEX_NONE;
+}
+
+void FRoseImportGraph::AddDependency(int32 Node, int32 DependsOn)
+{
+	check(Node != DependsOn);
+	if (!Nodes[Node].Dependencies.Contains(DependsOn))
+	{
+		Nodes[Node].Dependencies.Add(DependsOn);
+		Nodes[DependsOn].Dependents.Add(Node);
+	}
+}
+
+bool FRoseImportGraph::Finalize()
+{
+	// Kahn's algorithm from the leaves up, a node's level is one above its deepest dependency
+	TArray<int32> Remaining;
+	TArray<int32> Ready;
+	Remaining.SetNum(Nodes.Num());
+	for (int32 i = 0; i < Nodes.Num(); ++i)
+	{
+		Nodes[i].Level = 0;
+		Remaining[i] = Nodes[i].Dependencies.Num();
+		if (Remaining[i] == 0)
+		{
+			Ready.Add(i);
+		}
+	}
+
+	int32 Visited = 0;
+	while (Ready.Num() > 0)
+	{
+		const int32 NodeIdx = Ready.Pop(false);
+		++Visited;
+
+		for (int32 Dependent : Nodes[NodeIdx].Dependents)
+		{
+			Nodes[Dependent].Level = FMath::Max(Nodes[Dependent].Level, Nodes[NodeIdx].Level + 1);
+			if (--Remaining[Dependent] == 0)
+			{
+				Ready.Add(Dependent);
+			}
+		}
+	}
+
+	Levels.Reset();
+	if (Visited != Nodes.Num())
+	{
+		UE_LOG(LogTemp, Error, TEXT("Import graph has a dependency cycle, %d of %d nodes could be ordered"), Visited, Nodes.Num());
+		return false;
+	}
+
+	for (int32 i = 0; i < Nodes.Num(); ++i)
+	{
+		if (Levels.Num() <= Nodes[i].Level)
+		{
+			Levels.SetNum(Nodes[i].Level + 1);
+		}
+		Levels[Nodes[i].Level].Add(i);
+	}
+	return true;
+}
+
+TArray<int32> FRoseImportGraph::GetCriticalPath() const
+{
+	// Levels are in dependency order, so every dependency's best path is known before the node is reached
+	TArray<int64> PathCost;
+	TArray<int32> PathPrev;
+	PathCost.SetNumZeroed(Nodes.Num());
+	PathPrev.Init(INDEX_NONE, Nodes.Num());
+
+	int32 BestEnd = INDEX_NONE;
+	for (const TArray<int32>& Level : Levels)
+	{
+		for (int32 NodeIdx : Level)
+		{
+			const FNode& Node = Nodes[NodeIdx];
+			for (int32 Dependency : Node.Dependencies)
+			{
+				if (PathPrev[NodeIdx] == INDEX_NONE || PathCost[Dependency] > PathCost[PathPrev[NodeIdx]])
+				{
+					PathPrev[NodeIdx] = Dependency;
+				}
+			}
+			PathCost[NodeIdx] = Node.Cost + (PathPrev[NodeIdx] != INDEX_NONE ? PathCost[PathPrev[NodeIdx]] : 0);
+
+			if (BestEnd == INDEX_NONE || PathCost[NodeIdx] > PathCost[BestEnd])
+			{
+				BestEnd = NodeIdx;
+			}
+		}
+	}
+
+	TArray<int32> Path;
+	for (int32 NodeIdx = BestEnd; NodeIdx != INDEX_NONE; NodeIdx = PathPrev[NodeIdx])
+	{
+		Path.Insert(NodeIdx, 0);
+	}
+	return Path;
+}
+
+int64 FRoseImportGraph::GetTotalCost() const
+{
+	int64 Total = 0;
+	for (const FNode& Node : Nodes)
+	{
+		Total += Node.Cost;
+	}
+	return Total;
+}
+
+void FRoseImportGraph::LogSummary() const
+{
+	int32 KindCounts[ERoseNodeKind::Num] = { 0 };
+	for (const FNode& Node : Nodes)
+	{
+		++KindCounts[Node.Kind];
+	}
+
+	UE_LOG(LogTemp, Log, TEXT("Import graph: %d nodes, %d levels, %.2f MB of source data"), Nodes.Num(), Levels.Num(), GetTotalCost() / (1024.0 * 1024.0));
+	for (int32 k = 0; k < ERoseNodeKind::Num; ++k)
+	{
+		UE_LOG(LogTemp, Log, TEXT("  %s: %d"), GetKindName((ERoseNodeKind::Type)k), KindCounts[k]);
+	}
+	for (int32 l = 0; l < Levels.Num(); ++l)
+	{
+		UE_LOG(LogTemp, Log, TEXT("  Level %d: %d nodes"), l, Levels[l].Num());
+	}
+
+	TArray<int32> CriticalPath = GetCriticalPath();
+	int64 CriticalCost = 0;
+	for (int32 NodeIdx : CriticalPath)
+	{
+		CriticalCost += Nodes[NodeIdx].Cost;
+	}
+	UE_LOG(LogTemp, Log, TEXT("  Critical path: %d nodes, %.2f MB"), CriticalPath.Num(), CriticalCost / (1024.0 * 1024.0));
+	for (int32 NodeIdx : CriticalPath)
+	{
+		UE_LOG(LogTemp, Log, TEXT("    %s %s"), GetKindName(Nodes[NodeIdx].Kind), *Nodes[NodeIdx].Key);
+	}
+}
+
+const TCHAR* FRoseImportGraph::GetKindName(ERoseNodeKind::Type Kind)
+{
+	static const TCHAR* Names[] = {
+		TEXT("Zone"),
+		TEXT("Tile"),
+		TEXT("IFO"),
+		TEXT("HIM"),
+		TEXT("TIL"),
+		TEXT("Model"),
+		TEXT("ZMS"),
+		TEXT("ZMO"),
+		TEXT("Texture")
+	};
+	static_assert(ARRAY_COUNT(Names) == ERoseNodeKind::Num, "Node kind names out of date");
+	return Names[Kind];
+}
@@ -0,0 +1,93 @@
+#include "RoseImportSaver.h"
+#include "RoseImportStats.h"
+#include "Misc/PackageName.h"
+#include "UObject/Package.h"
+
+FRoseImportSaver::FRoseImportSaver(int32 InMaxInFlightPackages, int64 InMaxInFlightBytes)
+	: MaxInFlightPackages(FMath::Max(InMaxInFlightPackages, 1))
+	, MaxInFlightBytes(FMath::Max<int64>(InMaxInFlightBytes, 1))
+	, InFlightPackages(0)
+	, InFlightBytes(0)
+	, SavedCount(0)
+	, SavedBytes(0)
+{
+}
+
+FRoseImportSaver::~FRoseImportSaver()
+{
+	if (InFlightPackages > 0)
+	{
+		Flush();
+	}
+}
+
+void FRoseImportSaver::Add(UPackage* Package)
+{
+	if (Package != nullptr && !TrackedSet.Contains(Package))
+	{
+		TrackedSet.Add(Package);
+		Tracked.Add(Package);
+	}
+}
+
+int32 FRoseImportSaver::SaveDirty()
+{
+	FRoseImportPhaseScope Scope(ERoseImportPhase::PackageSave);
+
+	// A destroyed package may have its address reused, so the set is rebuilt from the live ones
+	if (Tracked.RemoveAll([](const TWeakObjectPtr<UPackage>& WeakPackage) { return !WeakPackage.IsValid(); }) > 0)
+	{
+		TrackedSet.Reset();
+		for (const TWeakObjectPtr<UPackage>& WeakPackage : Tracked)
+		{
+			TrackedSet.Add(WeakPackage.Get());
+		}
+	}
+
+	// Saved packages stay tracked, anything the import writes into them later is saved at a later boundary
+	int32 Saved = 0;
+	for (const TWeakObjectPtr<UPackage>& WeakPackage : Tracked)
+	{
+		UPackage* Package = WeakPackage.Get();
+		if (Package->IsDirty())
+		{
+			Saved += SavePackage(Package) ? 1 : 0;
+		}
+	}
+	return Saved;
+}
+
+void FRoseImportSaver::Flush()
+{
+	FRoseImportPhaseScope Scope(ERoseImportPhase::PackageSave);
+
+	UPackage::WaitForAsyncFileWrites();
+	InFlightPackages = 0;
+	InFlightBytes = 0;
+}
+
+bool FRoseImportSaver::SavePackage(UPackage* Package)
+{
+	const FString& Extension = Package->ContainsMap() ? FPackageName::GetMapPackageExtension() : FPackageName::GetAssetPackageExtension();
+	const FString Filename = FPackageName::LongPackageNameToFilename(Package->GetName(), Extension);
+
+	// SAVE_Async serializes into memory here and leaves the file write to a worker
+	FSavePackageResultStruct Result = UPackage::Save(Package, nullptr, RF_Standalone, *Filename, GWarn, nullptr, false, true, SAVE_Async | SAVE_NoError);
+	if (Result != ESavePackageResult::Success)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Could not save %s"), *Package->GetName());
+		return false;
+	}
+
+	++SavedCount;
+	SavedBytes += Result.TotalFileSize;
+
+	// The serialized buffers stay alive until their write finishes, so both limits bound memory as well as handles
+	++InFlightPackages;
+	InFlightBytes += Result.TotalFileSize;
+	if (InFlightPackages >= MaxInFlightPackages || InFlightBytes >= MaxInFlightBytes)
+	{
+		Flush();
+	}
+	return true;
+}
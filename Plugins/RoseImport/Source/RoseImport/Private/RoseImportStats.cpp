@@ -0,0 +1,288 @@
+#include "RoseImportStats.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformMemory.h"
+#include "HAL/Runnable.h"
+#include "HAL/RunnableThread.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonWriter.h"
+#include "Serialization/JsonSerializer.h"
+
+DECLARE_CYCLE_STAT(TEXT("Parse ZMS"), STAT_RoseImport_ParseZms, STATGROUP_RoseImport);
+DECLARE_CYCLE_STAT(TEXT("Parse ZMO"), STAT_RoseImport_ParseZmo, STATGROUP_RoseImport);
+DECLARE_CYCLE_STAT(TEXT("Parse ZSC"), STAT_RoseImport_ParseZsc, STATGROUP_RoseImport);
+DECLARE_CYCLE_STAT(TEXT("Parse ZMD"), STAT_RoseImport_ParseZmd, STATGROUP_RoseImport);
+DECLARE_CYCLE_STAT(TEXT("Parse CHR"), STAT_RoseImport_ParseChr, STATGROUP_RoseImport);
+DECLARE_CYCLE_STAT(TEXT("Parse IFO"), STAT_RoseImport_ParseIfo, STATGROUP_RoseImport);
+DECLARE_CYCLE_STAT(TEXT("Parse HIM"), STAT_RoseImport_ParseHim, STATGROUP_RoseImport);
+DECLARE_CYCLE_STAT(TEXT("Parse TIL"), STAT_RoseImport_ParseTil, STATGROUP_RoseImport);
+DECLARE_CYCLE_STAT(TEXT("Parse LIT"), STAT_RoseImport_ParseLit, STATGROUP_RoseImport);
+DECLARE_CYCLE_STAT(TEXT("Parse ZON"), STAT_RoseImport_ParseZon, STATGROUP_RoseImport);
+DECLARE_CYCLE_STAT(TEXT("Parse STB"), STAT_RoseImport_ParseStb, STATGROUP_RoseImport);
+DECLARE_CYCLE_STAT(TEXT("Texture Import"), STAT_RoseImport_TextureImport, STATGROUP_RoseImport);
+DECLARE_CYCLE_STAT(TEXT("Texture Atlas"), STAT_RoseImport_TextureAtlas, STATGROUP_RoseImport);
+DECLARE_CYCLE_STAT(TEXT("Material Create"), STAT_RoseImport_MaterialCreate, STATGROUP_RoseImport);
+DECLARE_CYCLE_STAT(TEXT("Mesh Build"), STAT_RoseImport_MeshBuild, STATGROUP_RoseImport);
+DECLARE_CYCLE_STAT(TEXT("Anim Import"), STAT_RoseImport_AnimImport, STATGROUP_RoseImport);
+DECLARE_CYCLE_STAT(TEXT("Blueprint Build"), STAT_RoseImport_BlueprintBuild, STATGROUP_RoseImport);
+DECLARE_CYCLE_STAT(TEXT("Landscape Import"), STAT_RoseImport_LandscapeImport, STATGROUP_RoseImport);
+DECLARE_CYCLE_STAT(TEXT("Actor Spawn"), STAT_RoseImport_ActorSpawn, STATGROUP_RoseImport);
+DECLARE_CYCLE_STAT(TEXT("HLOD Build"), STAT_RoseImport_HlodBuild, STATGROUP_RoseImport);
+DECLARE_CYCLE_STAT(TEXT("Package Save"), STAT_RoseImport_PackageSave, STATGROUP_RoseImport);
+
+/** Polls process memory while a run is in progress, so memory that rises and falls inside a phase is still seen */
+class FRoseImportMemorySampler : public FRunnable
+{
+public:
+
+	FRoseImportMemorySampler(FRoseImportStats& InStats)
+		: Stats(InStats)
+	{
+	}
+
+	virtual uint32 Run() override
+	{
+		while (StopRequested.GetValue() == 0)
+		{
+			Stats.SampleOpenPhases();
+			FPlatformProcess::Sleep(0.01f);
+		}
+		return 0;
+	}
+
+	virtual void Stop() override
+	{
+		StopRequested.Set(1);
+	}
+
+private:
+
+	FRoseImportStats& Stats;
+	FThreadSafeCounter StopRequested;
+};
+
+FRoseImportStats& FRoseImportStats::Get()
+{
+	static FRoseImportStats Instance;
+	return Instance;
+}
+
+FRoseImportStats::FRoseImportStats()
+	: Sampler(nullptr)
+	, SamplerThread(nullptr)
+{
+	for (int32 i = 0; i < ERoseImportPhase::Num; ++i)
+	{
+		PhasePeakMemory[i] = 0;
+	}
+	StartTime = FPlatformTime::Seconds();
+}
+
+void FRoseImportStats::Reset()
+{
+	StopSampling();
+
+	StartTime = FPlatformTime::Seconds();
+	for (int32 i = 0; i < ERoseImportPhase::Num; ++i)
+	{
+		PhaseCycles[i].Reset();
+		PhaseCalls[i].Reset();
+		FPlatformAtomics::InterlockedExchange(&PhasePeakMemory[i], 0);
+	}
+	for (int32 i = 0; i < ERoseImportCounter::Num; ++i)
+	{
+		Counters[i].Reset();
+	}
+
+	Sampler = new FRoseImportMemorySampler(*this);
+	SamplerThread = FRunnableThread::Create(Sampler, TEXT("RoseImportMemorySampler"), 0, TPri_BelowNormal);
+}
+
+void FRoseImportStats::StopSampling()
+{
+	if (SamplerThread != nullptr)
+	{
+		SamplerThread->Kill(true);
+		delete SamplerThread;
+		SamplerThread = nullptr;
+	}
+	delete Sampler;
+	Sampler = nullptr;
+}
+
+void FRoseImportStats::AddPhaseTime(ERoseImportPhase::Type Phase, uint64 Cycles)
+{
+	PhaseCycles[Phase].Add((int64)Cycles);
+	PhaseCalls[Phase].Increment();
+}
+
+void FRoseImportStats::Increment(ERoseImportCounter::Type Counter, int64 Amount)
+{
+	Counters[Counter].Add(Amount);
+}
+
+void FRoseImportStats::CountFile(const FString& Filename)
+{
+	Counters[ERoseImportCounter::Files].Increment();
+
+	int64 Size = IFileManager::Get().FileSize(*Filename);
+	if (Size > 0)
+	{
+		Counters[ERoseImportCounter::Bytes].Add(Size);
+	}
+}
+
+void FRoseImportStats::EnterPhase(ERoseImportPhase::Type Phase)
+{
+	PhaseOpen[Phase].Increment();
+	RaisePeakMemory(Phase, (int64)FPlatformMemory::GetStats().UsedPhysical);
+}
+
+void FRoseImportStats::ExitPhase(ERoseImportPhase::Type Phase)
+{
+	RaisePeakMemory(Phase, (int64)FPlatformMemory::GetStats().UsedPhysical);
+	PhaseOpen[Phase].Decrement();
+}
+
+void FRoseImportStats::SampleOpenPhases()
+{
+	const int64 Used = (int64)FPlatformMemory::GetStats().UsedPhysical;
+	for (int32 i = 0; i < ERoseImportPhase::Num; ++i)
+	{
+		if (PhaseOpen[i].GetValue() > 0)
+		{
+			RaisePeakMemory((ERoseImportPhase::Type)i, Used);
+		}
+	}
+}
+
+void FRoseImportStats::RaisePeakMemory(ERoseImportPhase::Type Phase, int64 Used)
+{
+	int64 Peak = FPlatformAtomics::AtomicRead(&PhasePeakMemory[Phase]);
+	while (Used > Peak)
+	{
+		int64 Previous = FPlatformAtomics::InterlockedCompareExchange(&PhasePeakMemory[Phase], Used, Peak);
+		if (Previous == Peak)
+		{
+			break;
+		}
+		Peak = Previous;
+	}
+}
+
+FString FRoseImportStats::WriteReport()
+{
+	StopSampling();
+
+	TSharedRef<FJsonObject> Root = MakeShared<FJsonObject>();
+	Root->SetNumberField(TEXT("wallSeconds"), FPlatformTime::Seconds() - StartTime);
+	// The true high water mark is only tracked by the OS, for the whole process since it started
+	Root->SetNumberField(TEXT("processPeakMemoryMB"), (double)FPlatformMemory::GetStats().PeakUsedPhysical / (1024.0 * 1024.0));
+
+	TSharedRef<FJsonObject> Phases = MakeShared<FJsonObject>();
+	for (int32 i = 0; i < ERoseImportPhase::Num; ++i)
+	{
+		TSharedRef<FJsonObject> PhaseObj = MakeShared<FJsonObject>();
+		PhaseObj->SetNumberField(TEXT("seconds"), FPlatformTime::ToSeconds64((uint64)PhaseCycles[i].GetValue()));
+		PhaseObj->SetNumberField(TEXT("calls"), (double)PhaseCalls[i].GetValue());
+		// Highest process memory seen while the phase was open, polled every 10ms and at scope entry and exit
+		PhaseObj->SetNumberField(TEXT("peakMemoryMB"), (double)FPlatformAtomics::AtomicRead(&PhasePeakMemory[i]) / (1024.0 * 1024.0));
+		Phases->SetObjectField(GetPhaseName((ERoseImportPhase::Type)i), PhaseObj);
+	}
+	Root->SetObjectField(TEXT("phases"), Phases);
+
+	TSharedRef<FJsonObject> CounterObj = MakeShared<FJsonObject>();
+	for (int32 i = 0; i < ERoseImportCounter::Num; ++i)
+	{
+		CounterObj->SetNumberField(GetCounterName((ERoseImportCounter::Type)i), (double)Counters[i].GetValue());
+	}
+	Root->SetObjectField(TEXT("counters"), CounterObj);
+
+	FString Output;
+	TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&Output);
+	FJsonSerializer::Serialize(Root, Writer);
+
+	FString Filename = FPaths::ProjectSavedDir() / TEXT("RoseImport") / FString::Printf(TEXT("ImportReport-%s.json"), *FDateTime::Now().ToString());
+	if (!FFileHelper::SaveStringToFile(Output, *Filename))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Failed to write import report - %s"), *Filename);
+		return FString();
+	}
+
+	UE_LOG(LogTemp, Log, TEXT("Import report written to %s"), *Filename);
+	return Filename;
+}
+
+TStatId FRoseImportStats::GetPhaseStatId(ERoseImportPhase::Type Phase)
+{
+	switch (Phase)
+	{
+	case ERoseImportPhase::ParseZms: return GET_STATID(STAT_RoseImport_ParseZms);
+	case ERoseImportPhase::ParseZmo: return GET_STATID(STAT_RoseImport_ParseZmo);
+	case ERoseImportPhase::ParseZsc: return GET_STATID(STAT_RoseImport_ParseZsc);
+	case ERoseImportPhase::ParseZmd: return GET_STATID(STAT_RoseImport_ParseZmd);
+	case ERoseImportPhase::ParseChr: return GET_STATID(STAT_RoseImport_ParseChr);
+	case ERoseImportPhase::ParseIfo: return GET_STATID(STAT_RoseImport_ParseIfo);
+	case ERoseImportPhase::ParseHim: return GET_STATID(STAT_RoseImport_ParseHim);
+	case ERoseImportPhase::ParseTil: return GET_STATID(STAT_RoseImport_ParseTil);
+	case ERoseImportPhase::ParseLit: return GET_STATID(STAT_RoseImport_ParseLit);
+	case ERoseImportPhase::ParseZon: return GET_STATID(STAT_RoseImport_ParseZon);
+	case ERoseImportPhase::ParseStb: return GET_STATID(STAT_RoseImport_ParseStb);
+	case ERoseImportPhase::TextureImport: return GET_STATID(STAT_RoseImport_TextureImport);
+	case ERoseImportPhase::TextureAtlas: return GET_STATID(STAT_RoseImport_TextureAtlas);
+	case ERoseImportPhase::MaterialCreate: return GET_STATID(STAT_RoseImport_MaterialCreate);
+	case ERoseImportPhase::MeshBuild: return GET_STATID(STAT_RoseImport_MeshBuild);
+	case ERoseImportPhase::AnimImport: return GET_STATID(STAT_RoseImport_AnimImport);
+	case ERoseImportPhase::BlueprintBuild: return GET_STATID(STAT_RoseImport_BlueprintBuild);
+	case ERoseImportPhase::LandscapeImport: return GET_STATID(STAT_RoseImport_LandscapeImport);
+	case ERoseImportPhase::ActorSpawn: return GET_STATID(STAT_RoseImport_ActorSpawn);
+	case ERoseImportPhase::HlodBuild: return GET_STATID(STAT_RoseImport_HlodBuild);
+	case ERoseImportPhase::PackageSave: return GET_STATID(STAT_RoseImport_PackageSave);
+	default: return TStatId();
+	}
+}
+
+const TCHAR* FRoseImportStats::GetPhaseName(ERoseImportPhase::Type Phase)
+{
+	static const TCHAR* Names[] = {
+		TEXT("ParseZms"),
+		TEXT("ParseZmo"),
+		TEXT("ParseZsc"),
+		TEXT("ParseZmd"),
+		TEXT("ParseChr"),
+		TEXT("ParseIfo"),
+		TEXT("ParseHim"),
+		TEXT("ParseTil"),
+		TEXT("ParseLit"),
+		TEXT("ParseZon"),
+		TEXT("ParseStb"),
+		TEXT("TextureImport"),
+		TEXT("TextureAtlas"),
+		TEXT("MaterialCreate"),
+		TEXT("MeshBuild"),
+		TEXT("AnimImport"),
+		TEXT("BlueprintBuild"),
+		TEXT("LandscapeImport"),
+		TEXT("ActorSpawn"),
+		TEXT("HlodBuild"),
+		TEXT("PackageSave")
+	};
+	static_assert(ARRAY_COUNT(Names) == ERoseImportPhase::Num, "Phase names out of date");
+	return Names[Phase];
+}
+
+const TCHAR* FRoseImportStats::GetCounterName(ERoseImportCounter::Type Counter)
+{
+	static const TCHAR* Names[] = {
+		TEXT("files"),
+		TEXT("bytes"),
+		TEXT("triangles"),
+		TEXT("assetsCreated"),
+		TEXT("cacheHits"),
+		TEXT("parseErrors"),
+		TEXT("textureDuplicates")
+	};
+	static_assert(ARRAY_COUNT(Names) == ERoseImportCounter::Num, "Counter names out of date");
+	return Names[Counter];
+}
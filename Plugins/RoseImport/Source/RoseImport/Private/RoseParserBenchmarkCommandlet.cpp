@@ -0,0 +1,424 @@
+#include "RoseParserBenchmarkCommandlet.h"
+#include "RoseImport.h"
+#include "HAL/FileManager.h"
+#include "HAL/MemoryBase.h"
+#include "HAL/PlatformMemory.h"
+#include "Templates/UniquePtr.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonWriter.h"
+#include "Serialization/JsonSerializer.h"
+
+#include "Zmd.h"
+#include "Zms.h"
+#include "Zmo.h"
+#include "Zsc.h"
+#include "Chr.h"
+#include "Him.h"
+#include "Ifo.h"
+#include "Til.h"
+#include "Lit.h"
+#include "Zon.h"
+#include "Stb.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogRoseParserBenchmark, Log, All);
+
+namespace RoseParserBenchmark
+{
+	/** Allocations counted for this thread, only while bCountThreadAllocs is set */
+	static thread_local int64 ThreadAllocs = 0;
+	static thread_local bool bCountThreadAllocs = false;
+
+	/** Forwards to the real allocator, counting allocations only on a thread that asked for them */
+	class FCountingMalloc : public FMalloc
+	{
+	public:
+		FCountingMalloc(FMalloc* InInner)
+			: Inner(InInner)
+		{
+		}
+
+		virtual void* Malloc(SIZE_T Count, uint32 Alignment) override
+		{
+			if (bCountThreadAllocs)
+			{
+				++ThreadAllocs;
+			}
+			return Inner->Malloc(Count, Alignment);
+		}
+
+		virtual void* Realloc(void* Original, SIZE_T Count, uint32 Alignment) override
+		{
+			if (bCountThreadAllocs && Count > 0)
+			{
+				++ThreadAllocs;
+			}
+			return Inner->Realloc(Original, Count, Alignment);
+		}
+
+		virtual void Free(void* Original) override
+		{
+			Inner->Free(Original);
+		}
+
+		virtual SIZE_T QuantizeSize(SIZE_T Count, uint32 Alignment) override
+		{
+			return Inner->QuantizeSize(Count, Alignment);
+		}
+
+		virtual bool GetAllocationSize(void* Original, SIZE_T& SizeOut) override
+		{
+			return Inner->GetAllocationSize(Original, SizeOut);
+		}
+
+		virtual void Trim(bool bTrimThreadCaches) override
+		{
+			Inner->Trim(bTrimThreadCaches);
+		}
+
+		virtual void SetupTLSCachesOnCurrentThread() override
+		{
+			Inner->SetupTLSCachesOnCurrentThread();
+		}
+
+		virtual void ClearAndDisableTLSCachesOnCurrentThread() override
+		{
+			Inner->ClearAndDisableTLSCachesOnCurrentThread();
+		}
+
+		virtual void UpdateStats() override
+		{
+			Inner->UpdateStats();
+		}
+
+		virtual void GetAllocatorStats(FGenericMemoryStats& OutStats) override
+		{
+			Inner->GetAllocatorStats(OutStats);
+		}
+
+		virtual bool IsInternallyThreadSafe() const override
+		{
+			return Inner->IsInternallyThreadSafe();
+		}
+
+		virtual const TCHAR* GetDescriptiveName() override
+		{
+			return TEXT("RoseParserBenchmark");
+		}
+
+		FMalloc* Inner;
+	};
+
+	/** Puts the counting allocator in front of GMalloc for the lifetime of the scope, nothing is counted until a thread asks */
+	class FCountingMallocScope
+	{
+	public:
+		FCountingMallocScope()
+			: Counter(GMalloc)
+		{
+			GMalloc = &Counter;
+		}
+
+		~FCountingMallocScope()
+		{
+			GMalloc = Counter.Inner;
+		}
+
+	private:
+		FCountingMalloc Counter;
+	};
+
+	/** Counts the allocations the current thread makes for the lifetime of the scope */
+	class FThreadAllocScope
+	{
+	public:
+		FThreadAllocScope(int64& InAllocs)
+			: Allocs(InAllocs), StartAllocs(ThreadAllocs)
+		{
+			bCountThreadAllocs = true;
+		}
+
+		~FThreadAllocScope()
+		{
+			bCountThreadAllocs = false;
+			Allocs += ThreadAllocs - StartAllocs;
+		}
+
+	private:
+		int64& Allocs;
+		int64 StartAllocs;
+	};
+
+	/** Takes the data by rvalue so the parser moves it in instead of copying inside the timed region */
+	template<typename ParsedType>
+	void ParseMemory(TArray<uint8>&& Data)
+	{
+		ParsedType Parsed(MoveTemp(Data));
+	}
+
+	template<typename ParsedType>
+	void ParseFile(const TCHAR* Filename)
+	{
+		ParsedType Parsed(Filename);
+	}
+
+	/** Process memory the parsed files hold on to, measured by keeping every file of the format parsed at once */
+	template<typename ParsedType>
+	double MeasureKBPerFile(const TArray<FString>& Files)
+	{
+		TArray<TUniquePtr<ParsedType>> Parsed;
+		Parsed.Reserve(Files.Num());
+		const uint64 UsedBefore = FPlatformMemory::GetStats().UsedPhysical;
+		for (int32 i = 0; i < Files.Num(); ++i)
+		{
+			Parsed.Add(MakeUnique<ParsedType>(*Files[i]));
+		}
+		const uint64 UsedAfter = FPlatformMemory::GetStats().UsedPhysical;
+		return UsedAfter > UsedBefore ? (double)(UsedAfter - UsedBefore) / 1024.0 / Files.Num() : 0.0;
+	}
+
+	/** IFO blocks are only decoded when asked for, so every kind is asked for or only the block table is measured */
+	template<>
+	void ParseMemory<Ifo>(TArray<uint8>&& Data)
+	{
+		Ifo Parsed(MoveTemp(Data));
+		Parsed.DecodeAll();
+	}
+
+	template<>
+	void ParseFile<Ifo>(const TCHAR* Filename)
+	{
+		Ifo Parsed(Filename);
+		Parsed.DecodeAll();
+	}
+
+	template<>
+	double MeasureKBPerFile<Ifo>(const TArray<FString>& Files)
+	{
+		TArray<TUniquePtr<Ifo>> Parsed;
+		Parsed.Reserve(Files.Num());
+		const uint64 UsedBefore = FPlatformMemory::GetStats().UsedPhysical;
+		for (int32 i = 0; i < Files.Num(); ++i)
+		{
+			Parsed.Add(MakeUnique<Ifo>(*Files[i]));
+			Parsed.Last()->DecodeAll();
+		}
+		const uint64 UsedAfter = FPlatformMemory::GetStats().UsedPhysical;
+		return UsedAfter > UsedBefore ? (double)(UsedAfter - UsedBefore) / 1024.0 / Files.Num() : 0.0;
+	}
+
+	struct FFormat
+	{
+		FFormat(const TCHAR* InName, void(*InParseMemory)(TArray<uint8>&&), void(*InParseFile)(const TCHAR*), double(*InMeasureKBPerFile)(const TArray<FString>&))
+			: Name(InName), ParseMemory(InParseMemory), ParseFile(InParseFile), MeasureKBPerFile(InMeasureKBPerFile), Bytes(0)
+		{
+		}
+
+		const TCHAR* Name;
+		void(*ParseMemory)(TArray<uint8>&&);
+		void(*ParseFile)(const TCHAR*);
+		double(*MeasureKBPerFile)(const TArray<FString>&);
+
+		TArray<FString> Files;
+		TArray<TArray<uint8>> Data;
+		int64 Bytes;
+	};
+
+	struct FResult
+	{
+		double MBPerSecond;
+		double ObjectsPerSecond;
+		double AllocsPerFile;
+		double KBPerFile;
+	};
+
+	FString GetBaselinePath(bool bCold)
+	{
+		return FPaths::ProjectSavedDir() / TEXT("RoseImport") / (bCold ? TEXT("ParserBaseline-Cold.json") : TEXT("ParserBaseline-Warm.json"));
+	}
+
+	FResult Run(const FFormat& Format, int32 Iterations, bool bCold)
+	{
+		// Warm iterations parse copies of the loaded files, made before the timer starts so only the parse is timed
+		TArray<TArray<uint8>> Scratch;
+		if (!bCold)
+		{
+			// One untimed pass so the first timed iteration is not paying for cold instruction and data caches
+			Scratch = Format.Data;
+			for (int32 i = 0; i < Scratch.Num(); ++i)
+			{
+				Format.ParseMemory(MoveTemp(Scratch[i]));
+			}
+		}
+
+		double Seconds = 0.0;
+		int64 Allocs = 0;
+		for (int32 Iter = 0; Iter < Iterations; ++Iter)
+		{
+			if (!bCold)
+			{
+				Scratch = Format.Data;
+			}
+
+			FThreadAllocScope AllocScope(Allocs);
+			const double StartTime = FPlatformTime::Seconds();
+			for (int32 i = 0; i < Format.Files.Num(); ++i)
+			{
+				if (bCold)
+				{
+					Format.ParseFile(*Format.Files[i]);
+				}
+				else
+				{
+					Format.ParseMemory(MoveTemp(Scratch[i]));
+				}
+			}
+			Seconds += FPlatformTime::Seconds() - StartTime;
+		}
+		Seconds = FMath::Max(Seconds, SMALL_NUMBER);
+
+		const double Parsed = (double)Format.Files.Num() * Iterations;
+		FResult Result;
+		Result.MBPerSecond = (double)Format.Bytes * Iterations / (1024.0 * 1024.0) / Seconds;
+		Result.ObjectsPerSecond = Parsed / Seconds;
+		Result.AllocsPerFile = (double)Allocs / Parsed;
+		Result.KBPerFile = Format.MeasureKBPerFile(Format.Files);
+		return Result;
+	}
+}
+
+URoseParserBenchmarkCommandlet::URoseParserBenchmarkCommandlet()
+{
+	IsClient = false;
+	IsEditor = true;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 URoseParserBenchmarkCommandlet::Main(const FString& Params)
+{
+	using namespace RoseParserBenchmark;
+
+	FString CorpusDir = RoseBasePath + TEXT("3DDATA");
+	FParse::Value(*Params, TEXT("corpus="), CorpusDir);
+
+	int32 Iterations = 5;
+	FParse::Value(*Params, TEXT("iterations="), Iterations);
+	Iterations = FMath::Max(Iterations, 1);
+
+	float Tolerance = 0.1f;
+	FParse::Value(*Params, TEXT("tolerance="), Tolerance);
+
+	const bool bCold = FParse::Param(*Params, TEXT("cold"));
+	const bool bSaveBaseline = FParse::Param(*Params, TEXT("savebaseline"));
+
+	TArray<FFormat> Formats;
+	Formats.Add(FFormat(TEXT("ZMS"), &ParseMemory<Zms>, &ParseFile<Zms>, &MeasureKBPerFile<Zms>));
+	Formats.Add(FFormat(TEXT("ZMO"), &ParseMemory<Zmo>, &ParseFile<Zmo>, &MeasureKBPerFile<Zmo>));
+	Formats.Add(FFormat(TEXT("ZSC"), &ParseMemory<Zsc>, &ParseFile<Zsc>, &MeasureKBPerFile<Zsc>));
+	Formats.Add(FFormat(TEXT("IFO"), &ParseMemory<Ifo>, &ParseFile<Ifo>, &MeasureKBPerFile<Ifo>));
+	Formats.Add(FFormat(TEXT("HIM"), &ParseMemory<Him>, &ParseFile<Him>, &MeasureKBPerFile<Him>));
+	Formats.Add(FFormat(TEXT("TIL"), &ParseMemory<Til>, &ParseFile<Til>, &MeasureKBPerFile<Til>));
+	Formats.Add(FFormat(TEXT("ZMD"), &ParseMemory<Zmd>, &ParseFile<Zmd>, &MeasureKBPerFile<Zmd>));
+	Formats.Add(FFormat(TEXT("CHR"), &ParseMemory<Chr>, &ParseFile<Chr>, &MeasureKBPerFile<Chr>));
+	Formats.Add(FFormat(TEXT("LIT"), &ParseMemory<Lit>, &ParseFile<Lit>, &MeasureKBPerFile<Lit>));
+	Formats.Add(FFormat(TEXT("ZON"), &ParseMemory<Zon>, &ParseFile<Zon>, &MeasureKBPerFile<Zon>));
+	Formats.Add(FFormat(TEXT("STB"), &ParseMemory<Stb>, &ParseFile<Stb>, &MeasureKBPerFile<Stb>));
+
+	TArray<FString> CorpusFiles;
+	IFileManager::Get().FindFilesRecursive(CorpusFiles, *CorpusDir, TEXT("*.*"), true, false);
+	for (int32 i = 0; i < CorpusFiles.Num(); ++i)
+	{
+		const FString Extension = FPaths::GetExtension(CorpusFiles[i]).ToUpper();
+		for (int32 f = 0; f < Formats.Num(); ++f)
+		{
+			if (Extension == Formats[f].Name)
+			{
+				FFormat& Format = Formats[f];
+				Format.Files.Add(CorpusFiles[i]);
+				if (bCold)
+				{
+					Format.Bytes += IFileManager::Get().FileSize(*CorpusFiles[i]);
+				}
+				else
+				{
+					TArray<uint8>& Data = Format.Data.AddDefaulted_GetRef();
+					FFileHelper::LoadFileToArray(Data, *CorpusFiles[i]);
+					Format.Bytes += Data.Num();
+				}
+				break;
+			}
+		}
+	}
+
+	TSharedPtr<FJsonObject> Baseline;
+	FString BaselineText;
+	if (FFileHelper::LoadFileToString(BaselineText, *GetBaselinePath(bCold)))
+	{
+		FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(BaselineText), Baseline);
+	}
+
+	UE_LOG(LogRoseParserBenchmark, Display, TEXT("Parsing %s over %d iterations (%s)"), *CorpusDir, Iterations,
+		bCold ? TEXT("cold, file reads included, served from the OS file cache after the first iteration") : TEXT("warm"));
+
+	TSharedRef<FJsonObject> Results = MakeShared<FJsonObject>();
+	int32 Regressions = 0;
+	FCountingMallocScope CountingMalloc;
+	for (int32 f = 0; f < Formats.Num(); ++f)
+	{
+		const FFormat& Format = Formats[f];
+		if (Format.Files.Num() == 0)
+		{
+			continue;
+		}
+
+		FResult Result = Run(Format, Iterations, bCold);
+		UE_LOG(LogRoseParserBenchmark, Display, TEXT("%s: %d files, %.2f MB/s, %.1f objects/s, %.1f allocs/file, %.1f KB/file"),
+			Format.Name, Format.Files.Num(), Result.MBPerSecond, Result.ObjectsPerSecond, Result.AllocsPerFile, Result.KBPerFile);
+
+		TSharedRef<FJsonObject> ResultObj = MakeShared<FJsonObject>();
+		ResultObj->SetNumberField(TEXT("mbPerSecond"), Result.MBPerSecond);
+		ResultObj->SetNumberField(TEXT("objectsPerSecond"), Result.ObjectsPerSecond);
+		ResultObj->SetNumberField(TEXT("allocsPerFile"), Result.AllocsPerFile);
+		ResultObj->SetNumberField(TEXT("kbPerFile"), Result.KBPerFile);
+		Results->SetObjectField(Format.Name, ResultObj);
+
+		const TSharedPtr<FJsonObject>* BaseObj = nullptr;
+		if (Baseline.IsValid() && Baseline->TryGetObjectField(Format.Name, BaseObj))
+		{
+			const double BaseMBPerSecond = (*BaseObj)->GetNumberField(TEXT("mbPerSecond"));
+			double BaseAllocsPerFile = 0.0;
+			double BaseKBPerFile = 0.0;
+			if (Result.MBPerSecond < BaseMBPerSecond * (1.0 - Tolerance))
+			{
+				UE_LOG(LogRoseParserBenchmark, Error, TEXT("%s: throughput regressed from %.2f to %.2f MB/s"), Format.Name, BaseMBPerSecond, Result.MBPerSecond);
+				++Regressions;
+			}
+			if ((*BaseObj)->TryGetNumberField(TEXT("allocsPerFile"), BaseAllocsPerFile) && Result.AllocsPerFile > BaseAllocsPerFile * (1.0 + Tolerance) + 0.5)
+			{
+				UE_LOG(LogRoseParserBenchmark, Error, TEXT("%s: allocations regressed from %.1f to %.1f per file"), Format.Name, BaseAllocsPerFile, Result.AllocsPerFile);
+				++Regressions;
+			}
+			// Resident memory moves in whole pages, so a change under a page per file is noise
+			if ((*BaseObj)->TryGetNumberField(TEXT("kbPerFile"), BaseKBPerFile) && Result.KBPerFile > BaseKBPerFile * (1.0 + Tolerance) + 4.0)
+			{
+				UE_LOG(LogRoseParserBenchmark, Error, TEXT("%s: memory regressed from %.1f to %.1f KB per file"), Format.Name, BaseKBPerFile, Result.KBPerFile);
+				++Regressions;
+			}
+		}
+	}
+
+	if (bSaveBaseline)
+	{
+		FString Output;
+		FJsonSerializer::Serialize(Results, TJsonWriterFactory<>::Create(&Output));
+		if (FFileHelper::SaveStringToFile(Output, *GetBaselinePath(bCold)))
+		{
+			UE_LOG(LogRoseParserBenchmark, Display, TEXT("Baseline saved to %s"), *GetBaselinePath(bCold));
+		}
+	}
+
+	return Regressions > 0 ? 1 : 0;
+}
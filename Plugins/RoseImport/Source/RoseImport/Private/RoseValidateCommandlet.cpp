@@ -0,0 +1,212 @@
+#include "RoseValidateCommandlet.h"
+#include "RoseImport.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Async/ParallelFor.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonWriter.h"
+#include "Serialization/JsonSerializer.h"
+
+#include "Zmd.h"
+#include "Zms.h"
+#include "Zmo.h"
+#include "Zsc.h"
+#include "Chr.h"
+#include "Him.h"
+#include "Ifo.h"
+#include "Til.h"
+#include "Lit.h"
+#include "Zon.h"
+#include "Stb.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogRoseValidate, Log, All);
+
+namespace RoseValidate
+{
+	template<typename ParsedType>
+	FString Validate(const TArray<uint8>& Data)
+	{
+		ParsedType Parsed(Data, true);
+		return Parsed.GetError().IsSet() ? Parsed.GetError().ToString() : FString();
+	}
+
+	/** IFO blocks are only decoded when asked for, so every kind is asked for */
+	template<>
+	FString Validate<Ifo>(const TArray<uint8>& Data)
+	{
+		Ifo Parsed(Data, true);
+		Parsed.DecodeAll();
+		return Parsed.GetError().IsSet() ? Parsed.GetError().ToString() : FString();
+	}
+
+	/** Textures are read from the PNG converted next to the DDS the list names, either one will do */
+	bool ReferenceExists(const FString& RosePath, bool bTexture)
+	{
+		const FString FullPath = RoseBasePath + RosePath;
+		return IFileManager::Get().FileExists(*FullPath)
+			|| (bTexture && IFileManager::Get().FileExists(*FPaths::ChangeExtension(FullPath, TEXT("png"))));
+	}
+
+	/** A model list is only as good as the files it names */
+	template<>
+	FString Validate<Zsc>(const TArray<uint8>& Data)
+	{
+		Zsc Parsed(Data, true);
+		if (Parsed.GetError().IsSet())
+		{
+			return Parsed.GetError().ToString();
+		}
+
+		for (const FString& Mesh : Parsed.meshes)
+		{
+			if (!ReferenceExists(Mesh, false))
+			{
+				return FString::Printf(TEXT("Missing mesh %s"), *Mesh);
+			}
+		}
+		for (const Zsc::Texture& Texture : Parsed.textures)
+		{
+			if (!ReferenceExists(Texture.filePath, true))
+			{
+				return FString::Printf(TEXT("Missing texture %s"), *Texture.filePath);
+			}
+		}
+		for (const Zsc::Model& Model : Parsed.models)
+		{
+			for (const Zsc::Part& Part : Model.parts)
+			{
+				if (!Part.animPath.IsEmpty() && !ReferenceExists(Part.animPath, false))
+				{
+					return FString::Printf(TEXT("Missing animation %s"), *Part.animPath);
+				}
+			}
+		}
+		return FString();
+	}
+
+	struct FFormat
+	{
+		FFormat(const TCHAR* InName, FString(*InValidate)(const TArray<uint8>&))
+			: Name(InName), Validate(InValidate)
+		{
+		}
+
+		const TCHAR* Name;
+		FString(*Validate)(const TArray<uint8>&);
+	};
+
+	struct FFileResult
+	{
+		FString Path;
+		const FFormat* Format;
+		int64 Bytes;
+		FString Error;
+	};
+}
+
+URoseValidateCommandlet::URoseValidateCommandlet()
+{
+	IsClient = false;
+	IsEditor = true;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 URoseValidateCommandlet::Main(const FString& Params)
+{
+	using namespace RoseValidate;
+
+	FString CorpusDir = RoseBasePath + TEXT("3DDATA");
+	FParse::Value(*Params, TEXT("corpus="), CorpusDir);
+
+	FString ReportPath = FPaths::ProjectSavedDir() / TEXT("RoseImport/ValidationReport.json");
+	FParse::Value(*Params, TEXT("report="), ReportPath);
+
+	TArray<FFormat> Formats;
+	Formats.Add(FFormat(TEXT("ZMS"), &Validate<Zms>));
+	Formats.Add(FFormat(TEXT("ZMO"), &Validate<Zmo>));
+	Formats.Add(FFormat(TEXT("ZSC"), &Validate<Zsc>));
+	Formats.Add(FFormat(TEXT("IFO"), &Validate<Ifo>));
+	Formats.Add(FFormat(TEXT("HIM"), &Validate<Him>));
+	Formats.Add(FFormat(TEXT("TIL"), &Validate<Til>));
+	Formats.Add(FFormat(TEXT("ZMD"), &Validate<Zmd>));
+	Formats.Add(FFormat(TEXT("CHR"), &Validate<Chr>));
+	Formats.Add(FFormat(TEXT("LIT"), &Validate<Lit>));
+	Formats.Add(FFormat(TEXT("ZON"), &Validate<Zon>));
+	Formats.Add(FFormat(TEXT("STB"), &Validate<Stb>));
+
+	TArray<FString> CorpusFiles;
+	IFileManager::Get().FindFilesRecursive(CorpusFiles, *CorpusDir, TEXT("*.*"), true, false);
+
+	TArray<FFileResult> Results;
+	Results.Reserve(CorpusFiles.Num());
+	for (const FString& File : CorpusFiles)
+	{
+		const FString Extension = FPaths::GetExtension(File).ToUpper();
+		const FFormat* Format = Formats.FindByPredicate([&Extension](const FFormat& F) { return Extension == F.Name; });
+		if (Format != nullptr)
+		{
+			FFileResult& Result = Results.AddDefaulted_GetRef();
+			Result.Path = File;
+			Result.Format = Format;
+			Result.Bytes = 0;
+		}
+	}
+
+	UE_LOG(LogRoseValidate, Display, TEXT("Validating %d files under %s"), Results.Num(), *CorpusDir);
+
+	// Each file is read and parsed on its own worker, the reads overlap with the parsing of other files
+	const double StartTime = FPlatformTime::Seconds();
+	ParallelFor(Results.Num(), [&Results](int32 i)
+	{
+		FFileResult& Result = Results[i];
+		TArray<uint8> Data;
+		if (!FFileHelper::LoadFileToArray(Data, *Result.Path))
+		{
+			Result.Error = TEXT("Could not be read");
+			return;
+		}
+		Result.Bytes = Data.Num();
+		Result.Error = Result.Format->Validate(Data);
+	});
+	const double Seconds = FPlatformTime::Seconds() - StartTime;
+
+	int64 TotalBytes = 0;
+	TArray<TSharedPtr<FJsonValue>> Failures;
+	for (const FFileResult& Result : Results)
+	{
+		TotalBytes += Result.Bytes;
+		if (Result.Error.IsEmpty())
+		{
+			continue;
+		}
+
+		UE_LOG(LogRoseValidate, Error, TEXT("%s: %s"), *Result.Path, *Result.Error);
+
+		TSharedRef<FJsonObject> FailureObj = MakeShared<FJsonObject>();
+		FailureObj->SetStringField(TEXT("path"), Result.Path);
+		FailureObj->SetStringField(TEXT("format"), Result.Format->Name);
+		FailureObj->SetStringField(TEXT("error"), Result.Error);
+		Failures.Add(MakeShared<FJsonValueObject>(FailureObj));
+	}
+
+	UE_LOG(LogRoseValidate, Display, TEXT("%d of %d files failed, %.2f MB checked in %.2f s"),
+		Failures.Num(), Results.Num(), TotalBytes / (1024.0 * 1024.0), Seconds);
+
+	TSharedRef<FJsonObject> Report = MakeShared<FJsonObject>();
+	Report->SetStringField(TEXT("corpus"), CorpusDir);
+	Report->SetNumberField(TEXT("files"), Results.Num());
+	Report->SetNumberField(TEXT("bytes"), (double)TotalBytes);
+	Report->SetNumberField(TEXT("seconds"), Seconds);
+	Report->SetArrayField(TEXT("failures"), Failures);
+
+	FString Output;
+	FJsonSerializer::Serialize(Report, TJsonWriterFactory<>::Create(&Output));
+	if (FFileHelper::SaveStringToFile(Output, *ReportPath))
+	{
+		UE_LOG(LogRoseValidate, Display, TEXT("Report saved to %s"), *ReportPath);
+	}
+
+	return Failures.Num() > 0 ? 1 : 0;
+}
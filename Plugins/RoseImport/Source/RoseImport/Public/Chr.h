@@ -26,24 +26,38 @@ public:
     };
 
     Chr(const TCHAR *Filename) {
-        FFileHelper::LoadFileToArray(rh.data, Filename);
+        if (!FFileHelper::LoadFileToArray(rh.data, Filename)) {
+            // Parsed as an empty file so every member is still set
+            rh.fail(ERoseParseError::Unreadable, TEXT("Could not be read"));
+            rh.checked = true;
+        }
+        Parse();
+    }
+
+    // Parses a file already held in memory, moved in when the caller passes an rvalue
+    Chr(TArray<uint8> Data, bool Checked = false) {
+        rh.data = MoveTemp(Data);
+        rh.checked = Checked;
+        Parse();
+    }
 
-        auto skeletonCount = rh.read<uint16>();
+    void Parse() {
+        auto skeletonCount = rh.readCount<uint16>(1);
         for (uint16 i = 0; i < skeletonCount; ++i) {
             skeletons.Add(rh.readStr());
         }
 
-        auto _animationCount = rh.read<uint16>();
+        auto _animationCount = rh.readCount<uint16>(1);
         for (uint16 i = 0; i < _animationCount; ++i) {
             animations.Add(rh.readStr());
         }
 
-        auto _effectCount = rh.read<uint16>();
+        auto _effectCount = rh.readCount<uint16>(1);
         for (uint16 i = 0; i < _effectCount; ++i) {
             effects.Add(rh.readStr());
         }
 
-        auto characterCount = rh.read<uint16>();
+        auto characterCount = rh.readCount<uint16>(1);
         for (uint16 i = 0; i < characterCount; ++i) {
             Character c;
             c.enabled = rh.read<uint8>() != 0;
@@ -52,12 +66,12 @@ public:
                 c.skeletonIdx = rh.read<uint16>();
                 c.name = rh.readStr();
 
-                auto modelCount = rh.read<uint16>();
+                auto modelCount = rh.readCount<uint16>(sizeof(uint16));
                 for (uint16 j = 0; j < modelCount; ++j) {
                     c.models.Add(rh.read<uint16>());
                 }
 
-                auto animationCount = rh.read<uint16>();
+                auto animationCount = rh.readCount<uint16>(sizeof(uint16) * 2);
                 for (uint16 j = 0; j < animationCount; ++j) {
                     Animation a;
                     a.type = rh.read<uint16>();
@@ -65,7 +79,7 @@ public:
                     c.animations.Add(a);
                 }
 
-                auto effectCount = rh.read<uint16>();
+                auto effectCount = rh.readCount<uint16>(sizeof(uint16) * 2);
                 for (uint16 j = 0; j < effectCount; ++j) {
                     Effect e;
                     e.boneIdx = rh.read<uint16>();
@@ -83,6 +97,11 @@ public:
     TArray<FString> effects;
     TArray<Character> characters;
 
+    // Not set unless the parse found the file malformed, test with IsSet(), see ReadHelper::checked
+    const FRoseParseError& GetError() const {
+        return rh.error;
+    }
+
 private:
     ReadHelper rh;
 };
\ No newline at end of file
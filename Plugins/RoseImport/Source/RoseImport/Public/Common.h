@@ -4,34 +4,83 @@
 
 #include "Math/Vector.h"
 
+struct ERoseParseError {
+	enum Type {
+		None,
+		Unreadable,
+		Truncated,
+		BadCount,
+		BadOffset,
+		BadIndex,
+		BadHeader,
+		UnknownValue
+	};
+};
+
+// What a parse found wrong with its file. Messages are literals, so recording one never allocates.
+struct FRoseParseError {
+	FRoseParseError() : Code(ERoseParseError::None), Offset(0), Message(TEXT("")) {
+	}
+
+	bool IsSet() const {
+		return Code != ERoseParseError::None;
+	}
+
+	FString ToString() const {
+		return FString::Printf(TEXT("%s at offset %d"), Message, Offset);
+	}
+
+	ERoseParseError::Type Code;
+	int32 Offset;
+	const TCHAR* Message;
+};
+
+// Reads one file's data. Parsers own their ReadHelper and touch nothing else, so any thread can parse as long as
+// no two share a parser.
 class ReadHelper {
 public:
-	ReadHelper() : pos(0) {
+	ReadHelper() : pos(0), checked(false) {
 	}
 
 	template<typename T> const T& read() {
+		if (checked && !require(sizeof(T))) {
+			return *(const T*)zeroes();
+		}
 		pos += sizeof(T);
 		return *(T*)&data[pos - sizeof(T)];
 	}
 
 	const char* read(int size) {
+		if (checked && !require(size)) {
+			return (const char*)zeroes();
+		}
 		auto out = (char*)&data[pos];
 		pos += size;
 		return out;
 	}
 
 	const char* readStr() {
+		if (checked && (!require(1) || memchr(&data[pos], 0, data.Num() - pos) == NULL)) {
+			fail(ERoseParseError::Truncated, TEXT("Unterminated string"));
+			return (const char*)zeroes();
+		}
 		auto out = (char*)&data[pos];
 		pos += strlen(out) + 1;
 		return out;
 	}
 
+	// Stops at the first NUL like the fixed buffer it replaces, but has no limit on the length
 	FString readStr(int32 len) {
-		char TempBuffer[256];
-		memcpy(TempBuffer, &data[pos], len);
-		TempBuffer[len] = 0;
+		if (checked && !require(len)) {
+			return FString();
+		}
+		const char* src = (const char*)&data[pos];
+		int32 strLen = 0;
+		while (strLen < len && src[strLen] != 0) {
+			++strLen;
+		}
 		pos += len;
-		return TempBuffer;
+		return FString(strLen, src);
 	}
 
 	FString readByteStr() {
@@ -49,30 +98,140 @@ public:
 		return FQuat(q.X, q.Y, q.Z, q.W);
 	}
 
+	// A count of elements at least elementSize bytes each, a count the rest of the file cannot hold fails as 0
+	template<typename T> T readCount(int32 elementSize) {
+		T count = read<T>();
+		return fits((int64)count, elementSize) ? count : 0;
+	}
+
+	// Whether count elements of elementSize bytes fit in what is left of the file, always true unless checked
+	bool fits(int64 count, int32 elementSize) {
+		if (!checked || (count >= 0 && count * elementSize <= (int64)data.Num() - pos)) {
+			return true;
+		}
+		fail(ERoseParseError::BadCount, TEXT("Count past the end of the file"));
+		return false;
+	}
+
+	// Whether idx indexes num elements, always true unless checked
+	bool checkIndex(int64 idx, int64 num, const TCHAR* what) {
+		if (!checked || (idx >= 0 && idx < num)) {
+			return true;
+		}
+		fail(ERoseParseError::BadIndex, what);
+		return false;
+	}
+
 	int tell() {
 		return pos;
 	}
 
 	void seek(int _pos) {
+		if (checked && (_pos < 0 || _pos > data.Num())) {
+			fail(ERoseParseError::BadOffset, TEXT("Offset past the end of the file"));
+			pos = data.Num();
+			return;
+		}
 		pos = _pos;
 	}
 
 	void skip(int num) {
+		if (checked && !require(num)) {
+			return;
+		}
 		pos += num;
 	}
 
+	// Keeps the first error only, everything after it is usually a consequence
+	void fail(ERoseParseError::Type code, const TCHAR* what) {
+		if (!error.IsSet()) {
+			error.Code = code;
+			error.Offset = pos;
+			error.Message = what;
+		}
+	}
+
 	int pos;
 	TArray<uint8> data;
+
+	// Checked reads never leave the data and return zeroes once anything failed, so a corrupt
+	// file ends its parse early instead of crashing. Files that passed a checked parse are read unchecked.
+	bool checked;
+	FRoseParseError error;
+
+private:
+	bool require(int64 size) {
+		if (!error.IsSet() && size >= 0 && pos >= 0 && pos + size <= data.Num()) {
+			return true;
+		}
+		fail(ERoseParseError::Truncated, TEXT("Read past the end of the file"));
+		return false;
+	}
+
+	// Stands in for data a failed checked read could not return, large enough for any string a length prefix can describe
+	static const uint8* zeroes() {
+		alignas(16) static const uint8 Zeroes[65536 + 16] = {};
+		return Zeroes;
+	}
+};
+
+// Mirror of ReadHelper that appends values in the same on-disk layout
+class WriteHelper {
+public:
+	template<typename T> void write(const T& value) {
+		data.Append((const uint8*)&value, sizeof(T));
+	}
+
+	void write(const void* src, int size) {
+		data.Append((const uint8*)src, size);
+	}
+
+	void writeStr(const FString& str) {
+		FTCHARToUTF8 conv(*str);
+		write(conv.Get(), conv.Length());
+		write<uint8>(0);
+	}
+
+	void writeByteStr(const FString& str) {
+		FTCHARToUTF8 conv(*str);
+		check(conv.Length() < 256);
+		write<uint8>(conv.Length());
+		write(conv.Get(), conv.Length());
+	}
+
+	void writeColor3(const FLinearColor& color) {
+		write<float>(color.R);
+		write<float>(color.G);
+		write<float>(color.B);
+	}
+
+	void writeBadQuat(const FQuat& q) {
+		write<float>(q.W);
+		write<float>(q.X);
+		write<float>(q.Y);
+		write<float>(q.Z);
+	}
+
+	// Overwrites a value written earlier, used for offsets that are only known later
+	template<typename T> void patch(int at, const T& value) {
+		memcpy(&data[at], &value, sizeof(T));
+	}
+
+	int tell() {
+		return data.Num();
+	}
+
+	TArray<uint8> data;
 };
 
-FVector rtuPosition(const FVector& v) {
+inline FVector rtuPosition(const FVector& v) {
 	return FVector(v.X, -v.Y, v.Z);
 };
 
-FQuat rtuRotation(const FQuat& q) {
+inline FQuat rtuRotation(const FQuat& q) {
 	return FQuat(-q.X, q.Y, -q.Z, q.W);
 };
 
-FVector rtuScale(const FVector& v) {
+inline FVector rtuScale(const FVector& v) {
 	return v;
 }
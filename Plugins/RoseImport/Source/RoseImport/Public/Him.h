@@ -5,14 +5,34 @@
 class Him {
 public:
     Him(const TCHAR *Filename) {
-        FFileHelper::LoadFileToArray(rh.data, Filename);
+        if (!FFileHelper::LoadFileToArray(rh.data, Filename)) {
+            // Parsed as an empty file so every member is still set
+            rh.fail(ERoseParseError::Unreadable, TEXT("Could not be read"));
+            rh.checked = true;
+        }
+        Parse();
+    }
+
+    // Parses a file already held in memory, moved in when the caller passes an rvalue
+    Him(TArray<uint8> Data, bool Checked = false) {
+        rh.data = MoveTemp(Data);
+        rh.checked = Checked;
+        Parse();
+    }
 
+    void Parse() {
         auto width = rh.read<uint32>();
         auto height = rh.read<uint32>();
         auto patchGridCount = rh.read<uint32>();
         auto patchSize = rh.read<float>();
         
-        check(width == 65 && height == 65);
+        if (width != 65 || height != 65) {
+            rh.fail(ERoseParseError::BadHeader, TEXT("HIM is not 65x65"));
+            return;
+        }
+        if (!rh.fits(width * height, sizeof(float))) {
+            return;
+        }
 
         heights.AddZeroed(width * height);
         for (uint32 y = 0; y < height; ++y) {
@@ -24,6 +44,11 @@ public:
 
     TArray<float> heights;
 
+    // Not set unless the parse found the file malformed, test with IsSet(), see ReadHelper::checked
+    const FRoseParseError& GetError() const {
+        return rh.error;
+    }
+
 private:
     ReadHelper rh;
 };
\ No newline at end of file
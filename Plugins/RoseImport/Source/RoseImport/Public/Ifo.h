@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Common.h"
+#include "Misc/ScopeLock.h"
 
 class Ifo {
 public:
@@ -45,40 +46,316 @@ public:
 	{
 	};
 
+	struct FAnimationBlock : public FMapBlock
+	{
+	};
+
+	struct FWarpBlock : public FMapBlock
+	{
+	};
+
+	struct FNpcBlock : public FMapBlock
+	{
+		int32 AiPattern;
+		FString ConversationFile;
+	};
+
+	struct FSoundBlock : public FMapBlock
+	{
+		FString FilePath;
+		int32 Range;
+		int32 Interval;
+	};
+
+	struct FEffectBlock : public FMapBlock
+	{
+		FString FilePath;
+	};
+
+	struct FEventBlock : public FMapBlock
+	{
+		FString FunctionName;
+		FString ConversationFile;
+	};
+
+	struct FSpawnMonster {
+		FString Name;
+		int32 MonsterId;
+		int32 Count;
+	};
+
+	struct FMonsterSpawnBlock : public FMapBlock
+	{
+		FString SpawnName;
+		TArray<FSpawnMonster> Basic;
+		TArray<FSpawnMonster> Tactic;
+		int32 Interval;
+		int32 Limit;
+		int32 Range;
+		int32 TacticPoints;
+	};
+
+	struct FMapInformation {
+		FIntPoint MapPosition;
+		FIntPoint ZonePosition;
+		FMatrix World;
+		FString Name;
+	};
+
+	struct FWaterPatch {
+		bool HasWater;
+		float Height;
+		int32 Type;
+		int32 Id;
+	};
+
+	struct FWaterPatches {
+		int32 Width;
+		int32 Height;
+		TArray<FWaterPatch> Patches;
+	};
+
+	struct FWaterPlane {
+		FVector Start;
+		FVector End;
+	};
+
+	struct FWaterPlanes {
+		float Size;
+		TArray<FWaterPlane> Planes;
+	};
+
+	// One entry of the block table, Count is the number of entries the block holds
+	struct FBlockEntry {
+		EBlockType::Type Type;
+		uint32 Offset;
+		int32 Count;
+	};
+
 	Ifo(const TCHAR *Filename) {
-		FFileHelper::LoadFileToArray(rh.data, Filename);
+		if (!FFileHelper::LoadFileToArray(rh.data, Filename)) {
+			// Parsed as an empty file so every member is still set
+			rh.fail(ERoseParseError::Unreadable, TEXT("Could not be read"));
+			rh.checked = true;
+		}
+		Parse();
+	}
 
-		auto blockCount = rh.read<uint32>();
+	// Parses a file already held in memory, moved in when the caller passes an rvalue
+	Ifo(TArray<uint8> Data, bool Checked = false) {
+		rh.data = MoveTemp(Data);
+		rh.checked = Checked;
+		Parse();
+	}
+
+	// Only reads the block table, every block kind is decoded from the kept file data the first time it is asked for
+	void Parse() {
+		decodedBlocks = 0;
+
+		auto blockCount = rh.readCount<uint32>(sizeof(uint32) * 2);
+		Blocks.Reserve(blockCount);
 		for (uint32 i = 0; i < blockCount; ++i) {
-			auto blockType = rh.read<uint32>();
-			auto blockOffset = rh.read<uint32>();
+			FBlockEntry Entry;
+			Entry.Type = (EBlockType::Type)rh.read<uint32>();
+			Entry.Offset = rh.read<uint32>();
+			Entry.Count = 0;
 
 			int32 nextBlock = rh.tell();
-			rh.seek(blockOffset);
+			rh.seek(Entry.Offset);
+			if (Entry.Type == EBlockType::MapInformation) {
+				Entry.Count = 1;
+			} else if (Entry.Type == EBlockType::WaterPatch) {
+				auto width = rh.read<int32>();
+				auto height = rh.read<int32>();
+				Entry.Count = rh.fits((int64)width * height, 1 + sizeof(float) + sizeof(int32) * 3) ? width * height : 0;
+			} else if (Entry.Type == EBlockType::WaterPlane) {
+				rh.skip(sizeof(float)); // Water size
+				Entry.Count = rh.readCount<int32>(sizeof(FVector) * 2);
+			} else {
+				// Every other block holds map objects, which start with the same base fields
+				Entry.Count = rh.readCount<int32>(1 + sizeof(uint16) * 2 + sizeof(uint32) * 4 + sizeof(FQuat) + sizeof(FVector) * 2);
+			}
+			Blocks.Add(Entry);
 
-			if (blockType == EBlockType::Object) {
-				uint32 objCount = rh.read<uint32>();
-				for (uint32 j = 0; j < objCount; ++j) {
-					Objects.Add(ReadBaseObject<FObjectBlock>());
-				}
-			} else if (blockType == EBlockType::Building) {
-				uint32 objCount = rh.read<uint32>();
-				for (uint32 j = 0; j < objCount; ++j) {
-					Buildings.Add(ReadBaseObject<FBuildingBlock>());
+			rh.seek(nextBlock);
+		}
+	}
+
+	const FBlockEntry* FindBlock(EBlockType::Type Type) const {
+		return Blocks.FindByPredicate([Type](const FBlockEntry& Entry) { return Entry.Type == Type; });
+	}
+
+	// Decodes every block kind at once, for passes that need the whole tile
+	void DecodeAll() const {
+		GetMapInformation();
+		GetObjects();
+		GetNpcs();
+		GetBuildings();
+		GetSounds();
+		GetEffects();
+		GetAnimations();
+		GetWaterPatches();
+		GetMonsterSpawns();
+		GetWaterPlanes();
+		GetWarpPoints();
+		GetCollisions();
+		GetEvents();
+	}
+
+	// The getters decode on first use under DecodeLock, so the same Ifo can be read from several threads at once
+	const FMapInformation& GetMapInformation() const {
+		FScopeLock Lock(&DecodeLock);
+		if (BeginDecode(EBlockType::MapInformation)) {
+			MapInformation.MapPosition = FIntPoint::ZeroValue;
+			MapInformation.ZonePosition = FIntPoint::ZeroValue;
+			MapInformation.World = FMatrix::Identity;
+			if (const FBlockEntry* Entry = FindBlock(EBlockType::MapInformation)) {
+				rh.seek(Entry->Offset);
+				MapInformation.MapPosition.X = rh.read<int32>();
+				MapInformation.MapPosition.Y = rh.read<int32>();
+				MapInformation.ZonePosition.X = rh.read<int32>();
+				MapInformation.ZonePosition.Y = rh.read<int32>();
+				MapInformation.World = rh.read<FMatrix>();
+				MapInformation.Name = rh.readByteStr();
+			}
+			EndDecode();
+		}
+		return MapInformation;
+	}
+
+	const TArray<FObjectBlock>& GetObjects() const {
+		return DecodeList(EBlockType::Object, Objects, &Ifo::ReadBaseObject<FObjectBlock>);
+	}
+
+	const TArray<FNpcBlock>& GetNpcs() const {
+		return DecodeList(EBlockType::NPC, Npcs, &Ifo::ReadNpc);
+	}
+
+	const TArray<FBuildingBlock>& GetBuildings() const {
+		return DecodeList(EBlockType::Building, Buildings, &Ifo::ReadBaseObject<FBuildingBlock>);
+	}
+
+	const TArray<FSoundBlock>& GetSounds() const {
+		return DecodeList(EBlockType::Sound, Sounds, &Ifo::ReadSound);
+	}
+
+	const TArray<FEffectBlock>& GetEffects() const {
+		return DecodeList(EBlockType::Effect, Effects, &Ifo::ReadEffect);
+	}
+
+	const TArray<FAnimationBlock>& GetAnimations() const {
+		return DecodeList(EBlockType::Animation, Animations, &Ifo::ReadBaseObject<FAnimationBlock>);
+	}
+
+	const FWaterPatches& GetWaterPatches() const {
+		FScopeLock Lock(&DecodeLock);
+		if (BeginDecode(EBlockType::WaterPatch)) {
+			WaterPatches.Width = 0;
+			WaterPatches.Height = 0;
+			if (const FBlockEntry* Entry = FindBlock(EBlockType::WaterPatch)) {
+				rh.seek(Entry->Offset);
+				WaterPatches.Width = rh.read<int32>();
+				WaterPatches.Height = rh.read<int32>();
+				WaterPatches.Patches.Reserve(Entry->Count);
+				for (int32 i = 0; i < Entry->Count; ++i) {
+					FWaterPatch p;
+					p.HasWater = rh.read<uint8>() != 0;
+					p.Height = rh.read<float>();
+					p.Type = rh.read<int32>();
+					p.Id = rh.read<int32>();
+					rh.skip(sizeof(int32)); // Reserved
+					WaterPatches.Patches.Add(p);
 				}
-			} else if (blockType == EBlockType::CollisionObject) {
-				uint32 objCount = rh.read<uint32>();
-				for (uint32 j = 0; j < objCount; ++j) {
-					Collisions.Add(ReadBaseObject<FCollisionBlock>());
+			}
+			EndDecode();
+		}
+		return WaterPatches;
+	}
+
+	const TArray<FMonsterSpawnBlock>& GetMonsterSpawns() const {
+		return DecodeList(EBlockType::MonsterSpawn, MonsterSpawns, &Ifo::ReadMonsterSpawn);
+	}
+
+	const FWaterPlanes& GetWaterPlanes() const {
+		FScopeLock Lock(&DecodeLock);
+		if (BeginDecode(EBlockType::WaterPlane)) {
+			WaterPlanes.Size = 0.0f;
+			if (const FBlockEntry* Entry = FindBlock(EBlockType::WaterPlane)) {
+				rh.seek(Entry->Offset);
+				WaterPlanes.Size = rh.read<float>();
+				rh.skip(sizeof(int32)); // Plane count
+				WaterPlanes.Planes.Reserve(Entry->Count);
+				for (int32 i = 0; i < Entry->Count; ++i) {
+					FWaterPlane p;
+					p.Start = rtuPosition(rh.read<FVector>());
+					p.End = rtuPosition(rh.read<FVector>());
+					WaterPlanes.Planes.Add(p);
 				}
 			}
+			EndDecode();
+		}
+		return WaterPlanes;
+	}
 
-			rh.seek(nextBlock);
+	const TArray<FWarpBlock>& GetWarpPoints() const {
+		return DecodeList(EBlockType::WarpPoint, WarpPoints, &Ifo::ReadBaseObject<FWarpBlock>);
+	}
+
+	const TArray<FCollisionBlock>& GetCollisions() const {
+		return DecodeList(EBlockType::CollisionObject, Collisions, &Ifo::ReadBaseObject<FCollisionBlock>);
+	}
+
+	const TArray<FEventBlock>& GetEvents() const {
+		return DecodeList(EBlockType::EventObject, Events, &Ifo::ReadEvent);
+	}
+
+	TArray<FBlockEntry> Blocks;
+
+	// Not set unless the parse found the file malformed, test with IsSet(), see ReadHelper::checked
+	const FRoseParseError& GetError() const {
+		return rh.error;
+	}
+
+private:
+	// True the first time a block kind is asked for, false once it has been decoded. Callers hold DecodeLock
+	bool BeginDecode(EBlockType::Type Type) const {
+		const uint32 Bit = 1u << Type;
+		if (decodedBlocks & Bit) {
+			return false;
+		}
+		decodedBlocks |= Bit;
+		return true;
+	}
+
+	// Drops the file data once every block kind has been decoded, nothing reads it after that
+	void EndDecode() const {
+		const uint32 AllBlocks = (1u << (EBlockType::EventObject + 1)) - 1;
+		if (decodedBlocks == AllBlocks) {
+			rh.data.Empty();
+		}
+	}
+
+	template<typename BlockType>
+	const TArray<BlockType>& DecodeList(EBlockType::Type Type, TArray<BlockType>& List, BlockType (Ifo::*ReadBlock)() const) const {
+		FScopeLock Lock(&DecodeLock);
+		if (BeginDecode(Type)) {
+			for (const FBlockEntry& Entry : Blocks) {
+				if (Entry.Type != Type) {
+					continue;
+				}
+				rh.seek(Entry.Offset + sizeof(uint32));
+				List.Reserve(List.Num() + Entry.Count);
+				for (int32 i = 0; i < Entry.Count; ++i) {
+					List.Add((this->*ReadBlock)());
+				}
+			}
+			EndDecode();
 		}
+		return List;
 	}
 
 	template<typename DerivedBlockType>
-	DerivedBlockType ReadBaseObject() {
+	DerivedBlockType ReadBaseObject() const {
 		DerivedBlockType data;
 		FMapBlock* obj = &data;
 		obj->Name = rh.readByteStr();
@@ -93,10 +370,73 @@ public:
 		return data;
 	}
 
-	TArray<FBuildingBlock> Buildings;
-	TArray<FObjectBlock> Objects;
-	TArray<FCollisionBlock> Collisions;
+	FNpcBlock ReadNpc() const {
+		FNpcBlock data = ReadBaseObject<FNpcBlock>();
+		data.AiPattern = rh.read<int32>();
+		data.ConversationFile = rh.readByteStr();
+		return data;
+	}
 
-private:
-	ReadHelper rh;
-};
\ No newline at end of file
+	FSoundBlock ReadSound() const {
+		FSoundBlock data = ReadBaseObject<FSoundBlock>();
+		data.FilePath = rh.readByteStr();
+		data.Range = rh.read<int32>();
+		data.Interval = rh.read<int32>();
+		return data;
+	}
+
+	FEffectBlock ReadEffect() const {
+		FEffectBlock data = ReadBaseObject<FEffectBlock>();
+		data.FilePath = rh.readByteStr();
+		return data;
+	}
+
+	FEventBlock ReadEvent() const {
+		FEventBlock data = ReadBaseObject<FEventBlock>();
+		data.FunctionName = rh.readByteStr();
+		data.ConversationFile = rh.readByteStr();
+		return data;
+	}
+
+	void ReadSpawnMonsters(TArray<FSpawnMonster>& Monsters) const {
+		auto count = rh.readCount<int32>(1 + sizeof(int32) * 2);
+		Monsters.Reserve(count);
+		for (int32 i = 0; i < count; ++i) {
+			FSpawnMonster m;
+			m.Name = rh.readByteStr();
+			m.MonsterId = rh.read<int32>();
+			m.Count = rh.read<int32>();
+			Monsters.Add(m);
+		}
+	}
+
+	FMonsterSpawnBlock ReadMonsterSpawn() const {
+		FMonsterSpawnBlock data = ReadBaseObject<FMonsterSpawnBlock>();
+		data.SpawnName = rh.readByteStr();
+		ReadSpawnMonsters(data.Basic);
+		ReadSpawnMonsters(data.Tactic);
+		data.Interval = rh.read<int32>();
+		data.Limit = rh.read<int32>();
+		data.Range = rh.read<int32>();
+		data.TacticPoints = rh.read<int32>();
+		return data;
+	}
+
+	// Guards decodedBlocks, the decoded members and rh, the getters only hand out a member once it is complete
+	mutable FCriticalSection DecodeLock;
+	mutable uint32 decodedBlocks;
+	mutable FMapInformation MapInformation;
+	mutable TArray<FObjectBlock> Objects;
+	mutable TArray<FNpcBlock> Npcs;
+	mutable TArray<FBuildingBlock> Buildings;
+	mutable TArray<FSoundBlock> Sounds;
+	mutable TArray<FEffectBlock> Effects;
+	mutable TArray<FAnimationBlock> Animations;
+	mutable FWaterPatches WaterPatches;
+	mutable TArray<FMonsterSpawnBlock> MonsterSpawns;
+	mutable FWaterPlanes WaterPlanes;
+	mutable TArray<FWarpBlock> WarpPoints;
+	mutable TArray<FCollisionBlock> Collisions;
+	mutable TArray<FEventBlock> Events;
+	mutable ReadHelper rh;
+};
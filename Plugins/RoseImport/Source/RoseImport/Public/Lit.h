@@ -0,0 +1,92 @@
+#pragma once
+
+#include "Common.h"
+
+// Baked lightmaps for one IFO object list of a tile, every lit part owns a cell of one of the listed DDS atlases
+class Lit {
+public:
+	struct Part {
+		FString name;
+		int32 partIdx;
+		FString ddsName;
+		int32 ddsIdx;
+		int32 pixelsPerPart;
+		int32 partsPerWidth;
+		int32 partPosition;
+
+		// Scale in XY and bias in ZW that move the part's own 0..1 lightmap UVs into its cell of the atlas
+		FVector4 GetScaleBias() const {
+			int32 perWidth = FMath::Max(partsPerWidth, 1);
+			float cellSize = 1.0f / perWidth;
+			return FVector4(cellSize, cellSize, (partPosition % perWidth) * cellSize, (partPosition / perWidth) * cellSize);
+		}
+	};
+
+	struct Object {
+		// Counts the blocks of the matching IFO list from 1
+		int32 objectId;
+		TArray<Part> parts;
+	};
+
+	Lit(const TCHAR *Filename) {
+		if (!FFileHelper::LoadFileToArray(rh.data, Filename)) {
+			// Parsed as an empty file so every member is still set
+			rh.fail(ERoseParseError::Unreadable, TEXT("Could not be read"));
+			rh.checked = true;
+		}
+		Parse();
+	}
+
+	// Parses a file already held in memory, moved in when the caller passes an rvalue
+	Lit(TArray<uint8> Data, bool Checked = false) {
+		rh.data = MoveTemp(Data);
+		rh.checked = Checked;
+		Parse();
+	}
+
+	void Parse() {
+		auto objectCount = rh.readCount<int32>(sizeof(int32) * 2);
+		for (int32 i = 0; i < objectCount; ++i) {
+			Object o;
+			auto partCount = rh.readCount<int32>(2 + sizeof(int32) * 5);
+			o.objectId = rh.read<int32>();
+
+			for (int32 j = 0; j < partCount; ++j) {
+				Part p;
+				p.name = rh.readByteStr();
+				p.partIdx = rh.read<int32>();
+				p.ddsName = rh.readByteStr();
+				p.ddsIdx = rh.read<int32>();
+				p.pixelsPerPart = rh.read<int32>();
+				p.partsPerWidth = rh.read<int32>();
+				p.partPosition = rh.read<int32>();
+				o.parts.Add(p);
+			}
+
+			objectLookup.Add(o.objectId, objects.Add(o));
+		}
+
+		auto ddsCount = rh.readCount<int32>(1);
+		for (int32 i = 0; i < ddsCount; ++i) {
+			ddsNames.Add(rh.readByteStr());
+		}
+	}
+
+	// The lightmap of an IFO block by its index in the list, NULL when the block was not baked
+	const Object* FindObject(int32 blockIdx) const {
+		const int32* objectIdx = objectLookup.Find(blockIdx + 1);
+		return objectIdx ? &objects[*objectIdx] : NULL;
+	}
+
+	TArray<Object> objects;
+	TArray<FString> ddsNames;
+
+	// Not set unless the parse found the file malformed, test with IsSet(), see ReadHelper::checked
+	const FRoseParseError& GetError() const {
+		return rh.error;
+	}
+
+private:
+	TMap<int32, int32> objectLookup;
+	ReadHelper rh;
+};
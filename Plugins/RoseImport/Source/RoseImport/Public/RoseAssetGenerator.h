@@ -0,0 +1,65 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Math/RandomStream.h"
+
+// Sizes of a generated zone, every count is per tile or per model so the output scales with the tile grid
+struct FRoseSynthOptions {
+	FRoseSynthOptions()
+		: ZoneName(TEXT("SYNTH")), MapName(TEXT("SYN01")), ZoneCount(1),
+		  StartX(31), StartY(30), TilesX(4), TilesY(4),
+		  MeshGridSize(16), BuildingModels(16), DecoModels(32), PartsPerModel(3),
+		  BuildingsPerTile(8), ObjectsPerTile(64), CollisionsPerTile(16),
+		  CharacterCount(16), BoneCount(24), AnimCount(4), AnimFrames(60),
+		  HeightAmplitude(2000.0f), Seed(0x5EED) {}
+
+	FString ZoneName;
+	FString MapName;
+	// Maps generated under the zone, all listed in one LIST_ZONE.STB. More than one are named MapName_00, MapName_01...
+	int32 ZoneCount;
+
+	int32 StartX;
+	int32 StartY;
+	int32 TilesX;
+	int32 TilesY;
+
+	// Vertices per side of every generated mesh, capped so the face indices still fit the uint16 counts
+	int32 MeshGridSize;
+	int32 BuildingModels;
+	int32 DecoModels;
+	int32 PartsPerModel;
+
+	int32 BuildingsPerTile;
+	int32 ObjectsPerTile;
+	int32 CollisionsPerTile;
+
+	int32 CharacterCount;
+	int32 BoneCount;
+	int32 AnimCount;
+	int32 AnimFrames;
+
+	float HeightAmplitude;
+	int32 Seed;
+};
+
+// Writers for valid ROSE files of controllable size, laid out like the client data under 3DDATA
+namespace RoseAssetGenerator {
+	// Every combination of the optional vertex attributes, position is always present
+	TArray<uint32> GetZmsFormatCombinations();
+
+	TArray<uint8> MakeZms(uint32 Format, int32 GridSize, int32 BoneCount, FRandomStream& Random);
+	TArray<uint8> MakeZmd(int32 BoneCount, int32 DummyCount);
+	TArray<uint8> MakeZmo(int32 BoneCount, int32 FrameCount, uint32 FramesPerSecond, FRandomStream& Random);
+	TArray<uint8> MakeZsc(const TArray<FString>& Meshes, const TArray<FString>& Textures, int32 ModelCount, int32 PartsPerModel, bool bSkinned, FRandomStream& Random);
+	TArray<uint8> MakeChr(const FString& ZmdPath, const TArray<FString>& Animations, int32 CharacterCount, int32 ModelCount, FRandomStream& Random);
+	TArray<uint8> MakeHim(int32 TileX, int32 TileY, float Amplitude);
+	TArray<uint8> MakeTil(FRandomStream& Random);
+	TArray<uint8> MakeIfo(int32 TileX, int32 TileY, const FRoseSynthOptions& Options, FRandomStream& Random);
+	TArray<uint8> MakeZon(const FRoseSynthOptions& Options, const TArray<FString>& Textures);
+	// Rows start with their row name, ColumnCount counts it as column 0 like Stb::GetCell
+	TArray<uint8> MakeStb(const TArray<TArray<FString>>& Rows, int32 ColumnCount);
+
+	// Writes ZoneCount complete maps with models and every tile, the shared characters and the LIST_ZONE.STB naming
+	// every map under OutDir, in the paths the importer reads. Returns the number of files written
+	int32 GenerateZones(const FString& OutDir, const FRoseSynthOptions& Options);
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "RoseAssetGeneratorCommandlet.generated.h"
+
+/**
+ * Writes synthetic ROSE zones so imports and benchmarks can run without the client data.
+ *
+ * UE4Editor-Cmd.exe <Project> -run=RoseAssetGenerator -out=<dir> [-zones=N] [-tilesx=N] [-tilesy=N] [-grid=N] [-objects=N] [-buildings=N]
+ *     [-collisions=N] [-models=N] [-parts=N] [-chars=N] [-bones=N] [-frames=N] [-seed=N]
+ *
+ * Import the result with -RoseBasePath=<dir>, every zone is listed in its LIST_ZONE.STB for zone list mode, or benchmark it with -run=RoseParserBenchmark -corpus=<dir>.
+ */
+UCLASS()
+class URoseAssetGeneratorCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+
+	URoseAssetGeneratorCommandlet();
+
+	// UCommandlet interface
+	virtual int32 Main(const FString& Params) override;
+};
@@ -4,12 +4,26 @@
 
 #include "CoreMinimal.h"
 #include "Modules/ModuleManager.h"
+#include "Misc/CommandLine.h"
+#include "Misc/Parse.h"
+#include "Misc/Paths.h"
 
 class FToolBarBuilder;
 class FMenuBuilder;
 
 const FString RosePackageName(TEXT("/Game/ROSEImp"));
-const FString RoseBasePath(TEXT("E:/Games/Ruff-Rose/"));
+
+// Root of the ROSE client data, -RoseBasePath=<dir> points the importer at another copy such as generated data
+inline FString GetRoseBasePath() {
+	FString BasePath(TEXT("E:/Games/Ruff-Rose/"));
+	if (FParse::Value(FCommandLine::Get(), TEXT("RoseBasePath="), BasePath)) {
+		FPaths::NormalizeDirectoryName(BasePath);
+		BasePath += TEXT("/");
+	}
+	return BasePath;
+}
+
+const FString RoseBasePath(GetRoseBasePath());
 
 
 
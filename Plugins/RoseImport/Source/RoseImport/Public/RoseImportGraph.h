@@ -0,0 +1,83 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+struct ERoseNodeKind
+{
+	enum Type
+	{
+		Zone,
+		Tile,
+		Ifo,
+		Him,
+		Til,
+		Model,
+		Zms,
+		Zmo,
+		Texture,
+		Num
+	};
+};
+
+/**
+ * Everything one import will touch, with an edge from each node to the nodes that must be done before it.
+ * Nodes are unique per kind and key, so a mesh or texture shared by many models is one leaf built once.
+ */
+class FRoseImportGraph
+{
+public:
+
+	struct FNode
+	{
+		ERoseNodeKind::Type Kind;
+
+		/** Normalized ROSE path for files, or a name unique within the kind for models and tiles */
+		FString Key;
+
+		/** Free for the caller, e.g. which list and which entry a model or tile comes from */
+		int32 ListIdx;
+		int32 ItemIdx;
+
+		/** Estimated work, the source file size for file nodes */
+		int64 Cost;
+
+		TArray<int32> Dependencies;
+		TArray<int32> Dependents;
+
+		/** Longest chain of dependencies below the node, leaves are level 0 */
+		int32 Level;
+	};
+
+	/** @return The existing node for the kind and key, or a new one */
+	int32 AddNode(ERoseNodeKind::Type Kind, const FString& Key, int32 ListIdx = INDEX_NONE, int32 ItemIdx = INDEX_NONE, int64 Cost = 0);
+
+	int32 FindNode(ERoseNodeKind::Type Kind, const FString& Key) const;
+
+	/** Node can only be built after DependsOn */
+	void AddDependency(int32 Node, int32 DependsOn);
+
+	/** Orders the graph, @return false if it has a cycle */
+	bool Finalize();
+
+	const FNode& GetNode(int32 Node) const { return Nodes[Node]; }
+
+	int32 Num() const { return Nodes.Num(); }
+
+	/** Nodes grouped by level, nothing in a level depends on anything else in it so each level can run in parallel */
+	const TArray<TArray<int32>>& GetLevels() const { return Levels; }
+
+	/** The chain of nodes with the largest total cost, from a leaf up to a root */
+	TArray<int32> GetCriticalPath() const;
+
+	int64 GetTotalCost() const;
+
+	void LogSummary() const;
+
+	static const TCHAR* GetKindName(ERoseNodeKind::Type Kind);
+
+private:
+
+	TArray<FNode> Nodes;
+	TMap<FString, int32> NodeLookup[ERoseNodeKind::Num];
+	TArray<TArray<int32>> Levels;
+};
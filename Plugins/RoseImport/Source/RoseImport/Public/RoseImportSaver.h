@@ -0,0 +1,50 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/WeakObjectPtr.h"
+
+class UPackage;
+
+/**
+ * Saves the packages an import creates as it goes, instead of leaving thousands of dirty packages for the editor.
+ * Serialization has to happen on the game thread, the file writes are handed to the async writer so they overlap
+ * with whatever the import does next. Writes in flight are bounded by count and bytes, past either the saver waits.
+ */
+class FRoseImportSaver
+{
+public:
+
+	FRoseImportSaver(int32 InMaxInFlightPackages = 128, int64 InMaxInFlightBytes = 256 * 1024 * 1024);
+
+	/** Waits for the writes still in flight, so no exit path leaves one behind */
+	~FRoseImportSaver();
+
+	/** Tracks a package for the rest of the import, it is saved at every boundary it is dirty at */
+	void Add(UPackage* Package);
+
+	/** Saves every tracked package that is dirty, @return The number saved */
+	int32 SaveDirty();
+
+	/** Waits for every write still in flight */
+	void Flush();
+
+	int32 GetSavedCount() const { return SavedCount; }
+
+	int64 GetSavedBytes() const { return SavedBytes; }
+
+private:
+
+	bool SavePackage(UPackage* Package);
+
+	int32 MaxInFlightPackages;
+	int64 MaxInFlightBytes;
+
+	TArray<TWeakObjectPtr<UPackage>> Tracked;
+	TSet<UPackage*> TrackedSet;
+
+	int32 InFlightPackages;
+	int64 InFlightBytes;
+
+	int32 SavedCount;
+	int64 SavedBytes;
+};
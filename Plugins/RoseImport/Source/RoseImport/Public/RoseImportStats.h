@@ -0,0 +1,135 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "HAL/ThreadSafeCounter.h"
+#include "HAL/ThreadSafeCounter64.h"
+
+class FRunnableThread;
+class FRoseImportMemorySampler;
+
+DECLARE_STATS_GROUP(TEXT("RoseImport"), STATGROUP_RoseImport, STATCAT_Advanced);
+
+struct ERoseImportPhase
+{
+	enum Type
+	{
+		ParseZms,
+		ParseZmo,
+		ParseZsc,
+		ParseZmd,
+		ParseChr,
+		ParseIfo,
+		ParseHim,
+		ParseTil,
+		ParseLit,
+		ParseZon,
+		ParseStb,
+		TextureImport,
+		TextureAtlas,
+		MaterialCreate,
+		MeshBuild,
+		AnimImport,
+		BlueprintBuild,
+		LandscapeImport,
+		ActorSpawn,
+		HlodBuild,
+		PackageSave,
+		Num
+	};
+};
+
+struct ERoseImportCounter
+{
+	enum Type
+	{
+		Files,
+		Bytes,
+		Triangles,
+		AssetsCreated,
+		CacheHits,
+		ParseErrors,
+		TextureDuplicates,
+		Num
+	};
+};
+
+/** Thread safe timings and counters for one import run, written out as a JSON report at the end */
+class FRoseImportStats
+{
+public:
+
+	static FRoseImportStats& Get();
+
+	/** Clears the run and starts polling process memory for the phases that are open */
+	void Reset();
+
+	/** Stops the memory polling, WriteReport does this too */
+	void StopSampling();
+
+	void AddPhaseTime(ERoseImportPhase::Type Phase, uint64 Cycles);
+
+	void Increment(ERoseImportCounter::Type Counter, int64 Amount = 1);
+
+	/** Counts a source file and its size */
+	void CountFile(const FString& Filename);
+
+	/** Marks a phase scope as open or closed, process memory counts towards the peak of every open phase */
+	void EnterPhase(ERoseImportPhase::Type Phase);
+	void ExitPhase(ERoseImportPhase::Type Phase);
+
+	/** Records the current process memory against every open phase it is a new high for */
+	void SampleOpenPhases();
+
+	/** @return The path of the written report, empty if it could not be written */
+	FString WriteReport();
+
+	static TStatId GetPhaseStatId(ERoseImportPhase::Type Phase);
+
+	static const TCHAR* GetPhaseName(ERoseImportPhase::Type Phase);
+
+	static const TCHAR* GetCounterName(ERoseImportCounter::Type Counter);
+
+private:
+
+	FRoseImportStats();
+
+	void RaisePeakMemory(ERoseImportPhase::Type Phase, int64 Used);
+
+	double StartTime;
+	FThreadSafeCounter64 PhaseCycles[ERoseImportPhase::Num];
+	FThreadSafeCounter64 PhaseCalls[ERoseImportPhase::Num];
+	FThreadSafeCounter PhaseOpen[ERoseImportPhase::Num];
+	volatile int64 PhasePeakMemory[ERoseImportPhase::Num];
+	FThreadSafeCounter64 Counters[ERoseImportCounter::Num];
+
+	FRoseImportMemorySampler* Sampler;
+	FRunnableThread* SamplerThread;
+};
+
+/** Times a phase in both the stat system and the import report, phases nest and are inclusive */
+class FRoseImportPhaseScope
+{
+public:
+
+	FRoseImportPhaseScope(ERoseImportPhase::Type InPhase)
+		: Phase(InPhase)
+		, CycleCounter(FRoseImportStats::GetPhaseStatId(InPhase))
+		, StartCycles(FPlatformTime::Cycles64())
+	{
+		FRoseImportStats::Get().EnterPhase(Phase);
+	}
+
+	~FRoseImportPhaseScope()
+	{
+		FRoseImportStats& Stats = FRoseImportStats::Get();
+		Stats.AddPhaseTime(Phase, FPlatformTime::Cycles64() - StartCycles);
+		Stats.ExitPhase(Phase);
+	}
+
+private:
+
+	ERoseImportPhase::Type Phase;
+	FScopeCycleCounter CycleCounter;
+	uint64 StartCycles;
+};
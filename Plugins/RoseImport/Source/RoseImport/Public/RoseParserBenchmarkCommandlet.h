@@ -0,0 +1,31 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "RoseParserBenchmarkCommandlet.generated.h"
+
+/**
+ * Measures the ROSE format parsers in isolation over a corpus of files.
+ *
+ * UE4Editor-Cmd.exe <Project> -run=RoseParserBenchmark -corpus=<dir> [-iterations=N] [-cold] [-savebaseline] [-tolerance=0.1]
+ *
+ * Warm mode parses files already held in memory and times only the parse, the files are copied before the timer
+ * starts and moved into the parser. Cold mode also times reading each file on every iteration, but after the first
+ * iteration those reads are normally served from the OS file cache, so it adds the file API cost rather than disk
+ * speed. Allocations per file are counted on the parsing thread only, inside the timed loop. Memory per file is the
+ * growth in resident process memory while every file of a format is held parsed.
+ * Results are compared against the baseline saved in Saved/RoseImport and the commandlet fails when any format is
+ * slower, allocates more, or holds more memory per file than the baseline by more than the tolerance.
+ */
+UCLASS()
+class URoseParserBenchmarkCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+
+	URoseParserBenchmarkCommandlet();
+
+	// UCommandlet interface
+	virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "RoseValidateCommandlet.generated.h"
+
+/**
+ * Checks a ROSE data set for malformed files before an import commits hours to it.
+ *
+ * UE4Editor-Cmd.exe <Project> -run=RoseValidate [-corpus=<dir>] [-report=<file>]
+ *
+ * Every file of a known format is parsed once on the task graph with bounds checked reads, so sizes, counts,
+ * offsets and indices are all held against the file, and the files a ZSC names have to exist under RoseBasePath.
+ * The report lists every bad file and the commandlet fails when there is one. Files that pass can be imported
+ * by the normal unchecked parsers.
+ */
+UCLASS()
+class URoseValidateCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+
+	URoseValidateCommandlet();
+
+	// UCommandlet interface
+	virtual int32 Main(const FString& Params) override;
+};
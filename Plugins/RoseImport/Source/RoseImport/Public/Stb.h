@@ -0,0 +1,92 @@
+#pragma once
+
+#include "Common.h"
+
+// STB data table, every cell is a string. Columns count the row name as column 0, like the client tools number them.
+class Stb {
+public:
+	Stb(const TCHAR *Filename) {
+		if (!FFileHelper::LoadFileToArray(rh.data, Filename)) {
+			// Parsed as an empty file so every member is still set
+			rh.fail(ERoseParseError::Unreadable, TEXT("Could not be read"));
+			rh.checked = true;
+		}
+		Parse();
+	}
+
+	// Parses a file already held in memory, moved in when the caller passes an rvalue
+	Stb(TArray<uint8> Data, bool Checked = false) {
+		rh.data = MoveTemp(Data);
+		rh.checked = Checked;
+		Parse();
+	}
+
+	void Parse() {
+		rh.skip(4); // STB1
+		auto dataOffset = rh.read<uint32>();
+		auto rowCount = rh.read<uint32>();
+		auto columnCount = rh.read<uint32>();
+		rh.skip(sizeof(uint32)); // Row height
+		if (!rh.fits((int64)columnCount + 1, sizeof(uint16))) {
+			columnCount = 0;
+		}
+		rh.skip(sizeof(uint16) * (columnCount + 1)); // Column widths
+
+		for (uint32 i = 0; i < columnCount; ++i) {
+			columnNames.Add(readShortStr());
+		}
+
+		// The first row and column hold the headers, only the rest carries data
+		rows = FMath::Max<int32>(rowCount - 1, 0);
+		columns = FMath::Max<int32>(columnCount - 1, 0);
+		if (!rh.fits((int64)rows * columns, sizeof(uint16))) {
+			rows = 0;
+			columns = 0;
+		}
+
+		for (int32 i = 0; i < rows; ++i) {
+			rowNames.Add(readShortStr());
+		}
+
+		rh.seek(dataOffset);
+		cells.Reserve(rows * columns);
+		for (int32 i = 0; i < rows * columns; ++i) {
+			cells.Add(readShortStr());
+		}
+	}
+
+	int32 GetRowCount() const {
+		return rows;
+	}
+
+	int32 GetColumnCount() const {
+		return columns + 1;
+	}
+
+	// Empty for anything outside the table, the same as a cell left blank
+	const FString& GetCell(int32 row, int32 column) const {
+		static const FString Empty;
+		if (row < 0 || row >= rows || column < 0 || column > columns) {
+			return Empty;
+		}
+		return column == 0 ? rowNames[row] : cells[row * columns + column - 1];
+	}
+
+	TArray<FString> columnNames;
+	TArray<FString> rowNames;
+
+	// Not set unless the parse found the file malformed, test with IsSet(), see ReadHelper::checked
+	const FRoseParseError& GetError() const {
+		return rh.error;
+	}
+
+private:
+	FString readShortStr() {
+		return rh.readStr(rh.read<uint16>());
+	}
+
+	int32 rows;
+	int32 columns;
+	TArray<FString> cells;
+	ReadHelper rh;
+};
@@ -14,10 +14,28 @@ public:
 #pragma pack(pop)
 
 	Til(const TCHAR *Filename) {
-		FFileHelper::LoadFileToArray(rh.data, Filename);
+		if (!FFileHelper::LoadFileToArray(rh.data, Filename)) {
+			// Parsed as an empty file so every member is still set
+			rh.fail(ERoseParseError::Unreadable, TEXT("Could not be read"));
+			rh.checked = true;
+		}
+		Parse();
+	}
+
+	// Parses a file already held in memory, moved in when the caller passes an rvalue
+	Til(TArray<uint8> Data, bool Checked = false) {
+		rh.data = MoveTemp(Data);
+		rh.checked = Checked;
+		Parse();
+	}
 
+	void Parse() {
 		Width = rh.read<uint32>();
 		Height = rh.read<uint32>();
+		if (!rh.fits((int64)Width * Height, sizeof(FTile))) {
+			Width = 0;
+			Height = 0;
+		}
 		Data.AddZeroed(Width * Height);
 		for (uint32 i = 0; i < Width * Height; ++i) {
 			Data[i] = rh.read<FTile>();
@@ -28,6 +46,11 @@ public:
 	uint32 Height;
 	TArray<FTile> Data;
 
+	// Not set unless the parse found the file malformed, test with IsSet(), see ReadHelper::checked
+	const FRoseParseError& GetError() const {
+		return rh.error;
+	}
+
 private:
 	ReadHelper rh;
 };
\ No newline at end of file
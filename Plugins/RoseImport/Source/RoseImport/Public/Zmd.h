@@ -1,20 +1,33 @@
 #pragma once
 
 #include "Common.h"
-#include "GenericPlatform/GenericPlatformMisc.h"
 
 class Zmd {
 public:
     struct Bone {
         uint32 parent;
-        char name[256];
+        FString name;
         FVector translation;
         FQuat rotation;
     };
 
     Zmd(const TCHAR *Filename) {
-        FFileHelper::LoadFileToArray(rh.data, Filename);
+        if (!FFileHelper::LoadFileToArray(rh.data, Filename)) {
+            // Parsed as an empty file so every member is still set
+            rh.fail(ERoseParseError::Unreadable, TEXT("Could not be read"));
+            rh.checked = true;
+        }
+        Parse();
+    }
+
+    // Parses a file already held in memory, moved in when the caller passes an rvalue
+    Zmd(TArray<uint8> Data, bool Checked = false) {
+        rh.data = MoveTemp(Data);
+        rh.checked = Checked;
+        Parse();
+    }
 
+    void Parse() {
         auto header = rh.read<char[7]>();
         uint32 version = 0;
         if (strncmp(header, "ZMD0002", 7) == 0) {
@@ -22,24 +35,25 @@ public:
         } else if (strncmp(header, "ZMD0003", 7) == 0) {
             version = 3;
         } else {
-            UE_DEBUG_BREAK();
+            rh.fail(ERoseParseError::BadHeader, TEXT("Unknown ZMD version"));
+            return;
         }
 
-        auto boneCount = rh.read<uint32>();
+        auto boneCount = rh.readCount<uint32>(sizeof(uint32) + 1 + sizeof(FVector) + sizeof(FQuat));
         for (uint32 i = 0; i < boneCount; ++i) {
             Bone b;
             b.parent = rh.read<uint32>();
-            strcpy_s(b.name, 256, rh.readStr());
+            b.name = rh.readStr();
             b.translation = rtuPosition(rh.read<FVector>());
             b.rotation = rtuRotation(rh.readBadQuat());
             bones.Add(b);
         }
 
-        auto dummyCount = rh.read<uint32>();
+        auto dummyCount = rh.readCount<uint32>(sizeof(uint32) + 1 + sizeof(FVector));
         for (uint32 i = 0; i < dummyCount; ++i) {
             Bone b;
             b.parent = rh.read<uint32>();
-            strcpy_s(b.name, 256, rh.readStr());
+            b.name = rh.readStr();
             b.translation = rtuPosition(rh.read<FVector>());
             b.rotation = (version == 3) ? rtuRotation(rh.readBadQuat()) : FQuat::Identity;
             dummies.Add(b);
@@ -49,6 +63,11 @@ public:
     TArray<Bone> bones;
     TArray<Bone> dummies;
 
+    // Not set unless the parse found the file malformed, test with IsSet(), see ReadHelper::checked
+    const FRoseParseError& GetError() const {
+        return rh.error;
+    }
+
 private:
     ReadHelper rh;
 };
\ No newline at end of file
@@ -1,7 +1,6 @@
 #pragma once
 
 #include "Common.h"
-#include "GenericPlatform/GenericPlatformMisc.h"
 
 class Zmo {
 public:
@@ -23,6 +22,7 @@ public:
     };
 
     struct Channel {
+        virtual ~Channel() {}
         uint32 index;
         virtual ChannelType::Type type() = 0;
     };
@@ -41,13 +41,27 @@ public:
     };
 
     Zmo(const TCHAR *Filename) {
-        FFileHelper::LoadFileToArray(rh.data, Filename);
+        if (!FFileHelper::LoadFileToArray(rh.data, Filename)) {
+            // Parsed as an empty file so every member is still set
+            rh.fail(ERoseParseError::Unreadable, TEXT("Could not be read"));
+            rh.checked = true;
+        }
+        Parse();
+    }
+
+    // Parses a file already held in memory, moved in when the caller passes an rvalue
+    Zmo(TArray<uint8> Data, bool Checked = false) {
+        rh.data = MoveTemp(Data);
+        rh.checked = Checked;
+        Parse();
+    }
 
+    void Parse() {
         auto header = rh.readStr();
 
         framesPerSecond = rh.read<uint32>();
         frameCount = rh.read<uint32>();
-        auto channelCount = rh.read<uint32>();
+        auto channelCount = rh.readCount<uint32>(sizeof(uint32) * 2);
 
         for (uint32 i = 0; i < channelCount; ++i) {
             Channel * channel = nullptr;
@@ -60,13 +74,19 @@ public:
             } else if (type == ChannelType::Scale) {
                 channel = new ScaleChannel();
             } else {
-                UE_DEBUG_BREAK();
+                rh.fail(ERoseParseError::UnknownValue, TEXT("Unknown ZMO channel type"));
+                return;
             }
 
             channel->index = rh.read<uint32>();
             channels.Add(channel);
         }
 
+        // Every channel stores at least a position per frame
+        if (!rh.fits((int64)frameCount * channelCount, sizeof(FVector))) {
+            frameCount = 0;
+        }
+
         for (uint32 j = 0; j < frameCount; ++j) {
             for (uint32 i = 0; i < channelCount; ++i) {
                 Channel *channel = channels[i];
@@ -80,17 +100,29 @@ public:
                 } else if (channel->type() == ChannelType::Scale) {
                     auto& frames = ((ScaleChannel*)channel)->frames;
                     frames.Add(rtuScale(rh.read<FVector>()));
-                } else {
-                    UE_DEBUG_BREAK();
                 }
             }
         }
     }
 
+    ~Zmo() {
+        for (int32 i = 0; i < channels.Num(); ++i) {
+            delete channels[i];
+        }
+    }
+
+    Zmo(const Zmo&) = delete;
+    Zmo& operator=(const Zmo&) = delete;
+
     uint32 framesPerSecond;
     uint32 frameCount;
     TArray<Channel*> channels;
 
+    // Not set unless the parse found the file malformed, test with IsSet(), see ReadHelper::checked
+    const FRoseParseError& GetError() const {
+        return rh.error;
+    }
+
 private:
     ReadHelper rh;
 };
\ No newline at end of file
@@ -24,20 +24,34 @@ public:
 	};
 
 	Zms(const TCHAR *Filename) {
-		FFileHelper::LoadFileToArray(rh.data, Filename);
+		if (!FFileHelper::LoadFileToArray(rh.data, Filename)) {
+			// Parsed as an empty file so every member is still set
+			rh.fail(ERoseParseError::Unreadable, TEXT("Could not be read"));
+			rh.checked = true;
+		}
+		Parse();
+	}
+
+	// Parses a file already held in memory, moved in when the caller passes an rvalue
+	Zms(TArray<uint8> Data, bool Checked = false) {
+		rh.data = MoveTemp(Data);
+		rh.checked = Checked;
+		Parse();
+	}
 
+	void Parse() {
 		auto header = rh.read<char[8]>();
 		auto format = rh.read<uint32>();
 		rh.skip(sizeof(FVector) * 2);
 
 		TArray<uint16> boneLookup;
-		auto boneCount = rh.read<uint16>();
+		auto boneCount = rh.readCount<uint16>(sizeof(uint16));
 		boneLookup.AddZeroed(boneCount);
 		for (uint16 i = 0; i < boneCount; ++i) {
 			boneLookup[i] = rh.read<uint16>();
 		}
 
-		auto vertexCount = rh.read<uint16>();
+		auto vertexCount = rh.readCount<uint16>(sizeof(FVector));
 		vertexPositions.AddZeroed(vertexCount);
 		for (uint16 i = 0; i < vertexCount; ++i) {
 			vertexPositions[i] = rtuPosition(rh.read<FVector>()) * 100;
@@ -46,7 +60,7 @@ public:
 		if (format & ZMSF_NORMAL) {
 			vertexNormals.AddZeroed(vertexCount);
 			for (uint16 i = 0; i < vertexCount; ++i) {
-				vertexNormals[i] = rh.read<FVector>();
+				vertexNormals[i] = rtuPosition(rh.read<FVector>());
 			}
 		}
 		if (format & ZMSF_COLOR) {
@@ -60,10 +74,10 @@ public:
 			boneWeights.AddZeroed(vertexCount);
 			for (uint16 i = 0; i < vertexCount; ++i) {
 				boneWeights[i] = rh.read<BoneWeights>();
-				boneWeights[i].boneIdx[0] = boneLookup[boneWeights[i].boneIdx[0]];
-				boneWeights[i].boneIdx[1] = boneLookup[boneWeights[i].boneIdx[1]];
-				boneWeights[i].boneIdx[2] = boneLookup[boneWeights[i].boneIdx[2]];
-				boneWeights[i].boneIdx[3] = boneLookup[boneWeights[i].boneIdx[3]];
+				for (int32 k = 0; k < 4; ++k) {
+					uint16 boneIdx = boneWeights[i].boneIdx[k];
+					boneWeights[i].boneIdx[k] = rh.checkIndex(boneIdx, boneLookup.Num(), TEXT("Bone index out of range")) ? boneLookup[boneIdx] : 0;
+				}
 			}
 		}
 		if (format & ZMSF_TANGENT) {
@@ -97,11 +111,12 @@ public:
 			}
 		}
 
-		auto faceCount = rh.read<uint16>();
+		auto faceCount = rh.readCount<uint16>(sizeof(uint16) * 3);
 		int indexCount = faceCount * 3;
 		indexes.AddZeroed(indexCount);
-		for (uint16 i = 0; i < indexCount; ++i) {
+		for (int i = 0; i < indexCount; ++i) {
 			indexes[i] = rh.read<uint16>();
+			rh.checkIndex(indexes[i], vertexCount, TEXT("Vertex index out of range"));
 		}
 	}
 
@@ -113,6 +128,11 @@ public:
 	TArray<uint32> indexes;
 	TArray<BoneWeights> boneWeights;
 
+	// Not set unless the parse found the file malformed, test with IsSet(), see ReadHelper::checked
+	const FRoseParseError& GetError() const {
+		return rh.error;
+	}
+
 private:
 	ReadHelper rh;
 };
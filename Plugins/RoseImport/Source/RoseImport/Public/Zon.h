@@ -1,13 +1,254 @@
 #pragma once
 
 #include "Common.h"
+#include "HAL/FileManager.h"
+#include "Misc/Paths.h"
 
 class Zon {
 public:
-    Zon(const TCHAR* Filename) {
-        FFileHelper::LoadFileToArray(rh.data, Filename);
-    }
+	struct EBlockType {
+		enum Type {
+			BasicInfo = 0,
+			EventPoints = 1,
+			Textures = 2,
+			Tiles = 3,
+			Economy = 4
+		};
+	};
+
+	struct FGridPosition {
+		bool IsUsed;
+		FVector2D Position;
+	};
+
+	struct FEventPoint {
+		FVector Position;
+		FString Name;
+	};
+
+	struct FTile {
+		int32 Layer1;
+		int32 Layer2;
+		int32 Offset1;
+		int32 Offset2;
+		bool IsBlending;
+		int32 Rotation;
+		int32 TileType;
+	};
+
+	struct FEconomy {
+		FString Name;
+		bool IsUnderground;
+		FString BackgroundMusic;
+		FString Sky;
+		int32 CheckRate;
+		int32 PopulationBase;
+		int32 PopulationGrowth;
+		int32 Consumption[10];
+	};
+
+	// HIM, TIL and IFO files found for one tile of the map directory
+	struct FTileFiles {
+		int32 X;
+		int32 Y;
+		bool HasHim;
+		bool HasTil;
+		bool HasIfo;
+	};
+
+	// Parses the zone and lists the tiles in the directory it was loaded from
+	Zon(const TCHAR *Filename) {
+		if (!FFileHelper::LoadFileToArray(rh.data, Filename)) {
+			// Parsed as an empty file so every member is still set
+			rh.fail(ERoseParseError::Unreadable, TEXT("Could not be read"));
+			rh.checked = true;
+		}
+		Parse();
+		ScanTileDirectory(FPaths::GetPath(Filename));
+	}
+
+	// Parses a file already held in memory, moved in when the caller passes an rvalue. The tile directory stays empty until ScanTileDirectory
+	Zon(TArray<uint8> Data, bool Checked = false) {
+		rh.data = MoveTemp(Data);
+		rh.checked = Checked;
+		Parse();
+	}
+
+	void Parse() {
+		ZoneType = 0;
+		Width = 0;
+		Height = 0;
+		GridCount = 0;
+		GridSize = 0.0f;
+		StartX = 0;
+		StartY = 0;
+		FMemory::Memzero(Economy.Consumption);
+		Economy.IsUnderground = false;
+		Economy.CheckRate = 0;
+		Economy.PopulationBase = 0;
+		Economy.PopulationGrowth = 0;
+
+		auto blockCount = rh.readCount<uint32>(sizeof(uint32) * 2);
+		for (uint32 i = 0; i < blockCount; ++i) {
+			auto blockType = rh.read<uint32>();
+			auto blockOffset = rh.read<uint32>();
+
+			int32 nextBlock = rh.tell();
+			rh.seek(blockOffset);
+
+			if (blockType == EBlockType::BasicInfo) {
+				ZoneType = rh.read<int32>();
+				Width = rh.read<int32>();
+				Height = rh.read<int32>();
+				GridCount = rh.read<int32>();
+				GridSize = rh.read<float>();
+				StartX = rh.read<int32>();
+				StartY = rh.read<int32>();
+
+				if (!rh.fits((int64)Width * Height, 1 + sizeof(FVector2D))) {
+					Width = 0;
+					Height = 0;
+				}
+				Grid.SetNum(Width * Height);
+				for (int32 j = 0; j < Width * Height; ++j) {
+					Grid[j].IsUsed = rh.read<uint8>() != 0;
+					Grid[j].Position.X = rh.read<float>();
+					Grid[j].Position.Y = rh.read<float>();
+				}
+			} else if (blockType == EBlockType::EventPoints) {
+				auto pointCount = rh.readCount<int32>(sizeof(FVector) + 1);
+				for (int32 j = 0; j < pointCount; ++j) {
+					FEventPoint e;
+					e.Position = rtuPosition(rh.read<FVector>());
+					e.Name = rh.readByteStr();
+					EventPoints.Add(e);
+				}
+			} else if (blockType == EBlockType::Textures) {
+				auto textureCount = rh.readCount<int32>(1);
+				for (int32 j = 0; j < textureCount; ++j) {
+					Textures.Add(rh.readByteStr());
+				}
+			} else if (blockType == EBlockType::Tiles) {
+				auto tileCount = rh.readCount<int32>(sizeof(int32) * 7);
+				for (int32 j = 0; j < tileCount; ++j) {
+					FTile t;
+					t.Layer1 = rh.read<int32>();
+					t.Layer2 = rh.read<int32>();
+					t.Offset1 = rh.read<int32>();
+					t.Offset2 = rh.read<int32>();
+					t.IsBlending = rh.read<int32>() != 0;
+					t.Rotation = rh.read<int32>();
+					t.TileType = rh.read<int32>();
+					Tiles.Add(t);
+				}
+			} else if (blockType == EBlockType::Economy) {
+				Economy.Name = rh.readByteStr();
+				Economy.IsUnderground = rh.read<int32>() != 0;
+				Economy.BackgroundMusic = rh.readByteStr();
+				Economy.Sky = rh.readByteStr();
+				Economy.CheckRate = rh.read<int32>();
+				Economy.PopulationBase = rh.read<int32>();
+				Economy.PopulationGrowth = rh.read<int32>();
+				for (int32 j = 0; j < ARRAY_COUNT(Economy.Consumption); ++j) {
+					Economy.Consumption[j] = rh.read<int32>();
+				}
+			}
+
+			rh.seek(nextBlock);
+		}
+	}
+
+	// Finds every <x>_<y>.HIM/TIL/IFO under MapDir, tiles come out sorted by row and then column
+	void ScanTileDirectory(const FString& MapDir) {
+		TileFiles.Reset();
+		TileLookup.Reset();
+
+		TArray<FString> Files;
+		IFileManager::Get().FindFiles(Files, *(MapDir / TEXT("*.*")), true, false);
+		for (const FString& File : Files) {
+			FString BaseName = FPaths::GetBaseFilename(File);
+			FString Extension = FPaths::GetExtension(File).ToUpper();
+			FString XPart, YPart;
+			if (!BaseName.Split(TEXT("_"), &XPart, &YPart) || !XPart.IsNumeric() || !YPart.IsNumeric()) {
+				continue;
+			}
+
+			FTileFiles& Tile = FindOrAddTile(FCString::Atoi(*XPart), FCString::Atoi(*YPart));
+			if (Extension == TEXT("HIM")) {
+				Tile.HasHim = true;
+			} else if (Extension == TEXT("TIL")) {
+				Tile.HasTil = true;
+			} else if (Extension == TEXT("IFO")) {
+				Tile.HasIfo = true;
+			}
+		}
+
+		// Names like 31_30.TXT still create an entry, only tiles with at least one map file are kept
+		TileFiles.RemoveAll([](const FTileFiles& Tile) { return !Tile.HasHim && !Tile.HasTil && !Tile.HasIfo; });
+		TileFiles.Sort([](const FTileFiles& A, const FTileFiles& B) { return A.Y != B.Y ? A.Y < B.Y : A.X < B.X; });
+
+		TileLookup.Reset();
+		for (int32 i = 0; i < TileFiles.Num(); ++i) {
+			TileLookup.Add(FIntPoint(TileFiles[i].X, TileFiles[i].Y), i);
+		}
+	}
+
+	const FTileFiles* FindTile(int32 X, int32 Y) const {
+		const int32* TileIdx = TileLookup.Find(FIntPoint(X, Y));
+		return TileIdx ? &TileFiles[*TileIdx] : NULL;
+	}
+
+	// Smallest rectangle holding every tile in the directory, false when it has none
+	bool GetTileBounds(int32& MinX, int32& MinY, int32& MaxX, int32& MaxY) const {
+		bool Found = false;
+		for (const FTileFiles& Tile : TileFiles) {
+			MinX = Found ? FMath::Min(MinX, Tile.X) : Tile.X;
+			MinY = Found ? FMath::Min(MinY, Tile.Y) : Tile.Y;
+			MaxX = Found ? FMath::Max(MaxX, Tile.X) : Tile.X;
+			MaxY = Found ? FMath::Max(MaxY, Tile.Y) : Tile.Y;
+			Found = true;
+		}
+		return Found;
+	}
+
+	int32 ZoneType;
+	int32 Width;
+	int32 Height;
+	int32 GridCount;
+	float GridSize;
+	int32 StartX;
+	int32 StartY;
+	TArray<FGridPosition> Grid;
+
+	TArray<FEventPoint> EventPoints;
+	TArray<FString> Textures;
+	TArray<FTile> Tiles;
+	FEconomy Economy;
+
+	TArray<FTileFiles> TileFiles;
+
+	// Not set unless the parse found the file malformed, test with IsSet(), see ReadHelper::checked
+	const FRoseParseError& GetError() const {
+		return rh.error;
+	}
 
 private:
+	FTileFiles& FindOrAddTile(int32 X, int32 Y) {
+		int32* TileIdx = TileLookup.Find(FIntPoint(X, Y));
+		if (TileIdx) {
+			return TileFiles[*TileIdx];
+		}
+
+		FTileFiles Tile;
+		Tile.X = X;
+		Tile.Y = Y;
+		Tile.HasHim = false;
+		Tile.HasTil = false;
+		Tile.HasIfo = false;
+		TileLookup.Add(FIntPoint(X, Y), TileFiles.Num());
+		return TileFiles.Add_GetRef(Tile);
+	}
+
+	TMap<FIntPoint, int32> TileLookup;
 	ReadHelper rh;
 };
@@ -85,14 +85,28 @@ public:
 	};
 
 	Zsc(const TCHAR *Filename) {
-		FFileHelper::LoadFileToArray(rh.data, Filename);
+		if (!FFileHelper::LoadFileToArray(rh.data, Filename)) {
+			// Parsed as an empty file so every member is still set
+			rh.fail(ERoseParseError::Unreadable, TEXT("Could not be read"));
+			rh.checked = true;
+		}
+		Parse();
+	}
+
+	// Parses a file already held in memory, moved in when the caller passes an rvalue
+	Zsc(TArray<uint8> Data, bool Checked = false) {
+		rh.data = MoveTemp(Data);
+		rh.checked = Checked;
+		Parse();
+	}
 
-		auto meshCount = rh.read<uint16>();
+	void Parse() {
+		auto meshCount = rh.readCount<uint16>(1);
 		for (uint16 i = 0; i < meshCount; ++i) {
 			meshes.Add(rh.readStr());
 		}
 
-		auto textureCount = rh.read<uint16>();
+		auto textureCount = rh.readCount<uint16>(1 + sizeof(uint16) * 10 + sizeof(float) * 4);
 		for (uint16 i = 0; i < textureCount; ++i) {
 			Texture t;
 			t.filePath = rh.readStr();
@@ -111,24 +125,25 @@ public:
 			textures.Add(t);
 		}
 
-		auto _effectCount = rh.read<uint16>();
+		auto _effectCount = rh.readCount<uint16>(1);
 		for (uint16 i = 0; i < _effectCount; ++i) {
 			effects.Add(rh.readStr());
 		}
 
-		char AnimPathBuffer[512];
-		auto modelCount = rh.read<uint16>();
+		auto modelCount = rh.readCount<uint16>(sizeof(int32) * 3 + sizeof(uint16));
 		for (uint16 i = 0; i < modelCount; ++i) {
 			rh.skip(sizeof(int32) * 3);
 
 			Model m;
 
-			auto partCount = rh.read<uint16>();
+			auto partCount = rh.readCount<uint16>(sizeof(uint16) * 2 + 1);
 			if (partCount > 0) {
 				for (uint16 j = 0; j < partCount; ++j) {
 					Part p;
 					p.meshIdx = rh.read<uint16>();
 					p.texIdx = rh.read<uint16>();
+					rh.checkIndex(p.meshIdx, meshes.Num(), TEXT("Mesh index out of range"));
+					rh.checkIndex(p.texIdx, textures.Num(), TEXT("Texture index out of range"));
 
 					p.position = FVector::ZeroVector;
 					p.rotation = FQuat::Identity;
@@ -136,6 +151,7 @@ public:
 					p.axisRotation = FQuat::Identity;
 					p.parentIdx = 0xFF;
 					p.collisionType = 0;
+					p.useLightmap = false;
 					p.boneIdx = 0xFFFF;
 					p.dummyIdx = 0xFFFF;
 
@@ -156,9 +172,9 @@ public:
 						} else if (propType == PropertyType::Collision) {
 							p.collisionType = rh.read<uint16>();
 						} else if (propType == PropertyType::ConstantAnimation) {
-							memcpy(AnimPathBuffer, rh.read(propSize), propSize);
-							AnimPathBuffer[propSize] = 0;
-							p.animPath = AnimPathBuffer;
+							p.animPath = rh.readStr(propSize);
+						} else if (propType == PropertyType::UseLightmap) {
+							p.useLightmap = rh.read<uint16>() != 0;
 						} else if (propType == PropertyType::BoneIndex) {
 							p.boneIdx = rh.read<uint16>();
 						} else if (propType == PropertyType::DummyIndex) {
@@ -171,7 +187,7 @@ public:
 					m.parts.Add(p);
 				}
 
-				auto effectCount = rh.read<uint16>();
+				auto effectCount = rh.readCount<uint16>(sizeof(uint16) * 2 + 1);
 				for (uint16 j = 0; j < effectCount; ++j) {
 					Effect e;
 					e.effectType = rh.read<uint16>();
@@ -214,6 +230,11 @@ public:
 	TArray<FString> effects;
 	TArray<Model> models;
 
+	// Not set unless the parse found the file malformed, test with IsSet(), see ReadHelper::checked
+	const FRoseParseError& GetError() const {
+		return rh.error;
+	}
+
 private:
 	ReadHelper rh;
 };
\ No newline at end of file
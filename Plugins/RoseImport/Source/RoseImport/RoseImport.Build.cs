@@ -53,7 +53,10 @@ public class RoseImport : ModuleRules
 				"AssetRegistry",
 				"LandscapeEditor",
 				"TargetPlatform",
-				"BlueprintGraph"
+				"BlueprintGraph",
+				"Json",
+				"ImageWrapper",
+				"HierarchicalLODUtilities"
 				// ... add private dependencies that you statically link with here ...	
 			}
 			);